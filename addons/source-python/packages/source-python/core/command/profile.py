@@ -0,0 +1,96 @@
+# ../core/command/profile.py
+
+"""Registers the sp profile sub-commands."""
+
+# =============================================================================
+# >> IMPORTS
+# =============================================================================
+# Source.Python Imports
+#   Commands
+from commands.typed import TypedServerCommand
+#   Core
+from core.command import core_command
+from core.command import core_command_logger
+#   Memory
+from memory.hooks import get_hook_profiling
+from memory.hooks import get_hook_stats
+from memory.hooks import reset_hook_stats
+from memory.hooks import set_hook_profiling
+
+
+# =============================================================================
+# >> sp profile
+# =============================================================================
+@core_command.server_sub_command(['profile', 'enable'])
+def _sp_profile_enable(command_info):
+    """Start recording the time spent in hooks."""
+    set_hook_profiling(True)
+    core_command_logger.log_message('Hook profiling has been enabled.')
+
+@core_command.server_sub_command(['profile', 'disable'])
+def _sp_profile_disable(command_info):
+    """Stop recording the time spent in hooks."""
+    set_hook_profiling(False)
+    core_command_logger.log_message('Hook profiling has been disabled.')
+
+@core_command.server_sub_command(['profile', 'reset'])
+def _sp_profile_reset(command_info):
+    """Reset the recorded hook stats."""
+    reset_hook_stats()
+    core_command_logger.log_message('Hook stats have been reset.')
+
+@core_command.server_sub_command(['profile', 'hooks'])
+def _sp_profile_hooks(command_info, limit:int=20):
+    """Print the hooks and callbacks that took the most time."""
+    stats = sorted(
+        get_hook_stats().items(),
+        key=lambda item: item[1].total_time,
+        reverse=True)
+
+    if not stats:
+        if get_hook_profiling():
+            message = 'No hook calls have been recorded yet.'
+        else:
+            message = 'Hook profiling is disabled. Use "sp profile enable".'
+
+        core_command_logger.log_message(message)
+        return
+
+    message = '\n{:<10} {:<5} {:>9} {:>9} {:>11} {:>10} {:>10}  {}\n'.format(
+        'Address', 'Type', 'Calls', 'Overrides', 'Total (ms)', 'Avg (us)',
+        'Max (us)', 'Callback')
+    message += '=' * 100 + '\n'
+    for (address, hook_type, callback), hook_stats in stats[:limit]:
+        message += '{:<#10x} {:<5} {:>9} {:>9} {:>11.3f} {:>10.2f} {:>10.2f}  {}\n'.format(
+            address,
+            hook_type.name,
+            hook_stats.calls,
+            hook_stats.overrides,
+            hook_stats.total_time * 1000,
+            hook_stats.average_time * 1000000,
+            hook_stats.max_time * 1000000,
+            _get_callback_name(callback))
+
+    core_command_logger.log_message(message)
+
+
+# =============================================================================
+# >> HELPER FUNCTIONS
+# =============================================================================
+def _get_callback_name(callback):
+    """Return a readable name of a hook callback."""
+    if callback is None:
+        return '<all callbacks and native hooks>'
+
+    name = getattr(callback, '__qualname__', None)
+    if name is None:
+        return repr(callback)
+
+    return '{}.{}'.format(callback.__module__, name)
+
+
+# =============================================================================
+# >> DESCRIPTIONS
+# =============================================================================
+TypedServerCommand.parser.set_node_description(
+    ['sp', 'profile'], 'Hook profiling commands.')
@@ -27,8 +27,15 @@ from _memory import Convention
 from _memory import DataType
 from _memory import EXPOSED_CLASSES
 from _memory import Function
+from _memory import FrameArena
 from _memory import FunctionInfo
+from _memory import NATIVE_RETURN_VALUE
 from _memory import NULL
+from _memory import NativeAction
+from _memory import NativeActionType
+from _memory import NativeAttribute
+from _memory import NativeCompare
+from _memory import NativeCondition
 from _memory import Pointer
 from _memory import ProcessorRegister
 from _memory import Register
@@ -37,6 +44,7 @@ from _memory import StackData
 from _memory import TYPE_SIZES
 from _memory import alloc
 from _memory import find_binary
+from _memory import frame_arena
 from _memory import get_data_type_size
 from _memory import get_object_pointer
 from _memory import get_size
@@ -53,9 +61,16 @@ __all__ = ('BinaryFile',
            'Convention',
            'DataType',
            'EXPOSED_CLASSES',
+           'FrameArena',
            'Function',
            'FunctionInfo',
+           'NATIVE_RETURN_VALUE',
            'NULL',
+           'NativeAction',
+           'NativeActionType',
+           'NativeAttribute',
+           'NativeCompare',
+           'NativeCondition',
            'Pointer',
            'ProcessorRegister',
            'Register',
@@ -64,6 +79,7 @@ __all__ = ('BinaryFile',
            'TYPE_SIZES',
            'alloc',
            'find_binary',
+           'frame_arena',
            'get_class',
            'get_class_info',
            'get_class_name',
@@ -281,6 +281,29 @@ class Array(BasePointer):
         # Every x bytes is a new instance
         return index * cls._size
 
+    def as_memoryview(self):
+        """Return a memoryview of the whole array without copying it.
+
+        This requires the array to have a length and to contain pointers or
+        a native type (except strings).
+
+        :rtype: memoryview
+        """
+        if self._length is None:
+            raise ValueError(
+                'Cannot create a memoryview without _length being specified.')
+
+        if self._is_ptr:
+            format_char = 'P'
+        else:
+            format_char = _BUFFER_FORMATS.get(self._type_name)
+            if format_char is None:
+                raise TypeError(
+                    'Unable to create a memoryview of "{0}" values.'.format(
+                        self._type_name))
+
+        return super().as_memoryview(self.get_offset(self._length), format_char)
+
     # Arrays have another constructor and we don't want to downcast. So, we
     # have to implement these operators here again.
     def __add__(self, other):
@@ -319,6 +342,7 @@ class MemberFunction(Function):
         super().__init__(
             func.address, func.convention, func.arguments, func.return_type
         )
+        self.thread_safe = func.thread_safe
 
         # This should always hold a TypeManager instance
         self._manager = manager
@@ -341,6 +365,11 @@ class MemberFunction(Function):
         """Call the function, but skip hooks if there are any."""
         return super().skip_hooks(self._this, *args)
 
+    def call_many(self, arguments):
+        """Call the function once for every argument sequence."""
+        this = self._this
+        return super().call_many((this,) + tuple(args) for args in arguments)
+
 
 # =============================================================================
 # >> FUNCTIONS
@@ -404,3 +433,21 @@ def parse_data(manager, raw_data, keys):
 # Use this as a default value if the key is not allowed to have a default
 # value
 NO_DEFAULT = object()
+
+# Native types that can be viewed with Array.as_memoryview()
+_BUFFER_FORMATS = {
+    Type.BOOL: '?',
+    Type.CHAR: 'c',
+    Type.UCHAR: 'B',
+    Type.SHORT: 'h',
+    Type.USHORT: 'H',
+    Type.INT: 'i',
+    Type.UINT: 'I',
+    Type.LONG: 'l',
+    Type.ULONG: 'L',
+    Type.LONG_LONG: 'q',
+    Type.ULONG_LONG: 'Q',
+    Type.FLOAT: 'f',
+    Type.DOUBLE: 'd',
+    Type.POINTER: 'P',
+}
@@ -12,21 +12,34 @@ from contextlib import contextmanager
 #   Core
 from core import AutoUnload
 #   Memory
+from _memory import HOOK_STOP
+from _memory import HookStats
 from _memory import HookType
 from _memory import set_hooks_disabled
 from _memory import get_hooks_disabled
+from _memory import set_hook_profiling
+from _memory import get_hook_profiling
+from _memory import get_hook_stats
+from _memory import reset_hook_stats
 from memory import Function
 
 
 # =============================================================================
 # >> ALL DECLARATION
 # =============================================================================
-__all__ = ('HookType',
+__all__ = ('DeferredPostHook',
+           'HOOK_STOP',
+           'HookStats',
+           'HookType',
            'PostHook',
            'PreHook',
            'set_hooks_disabled',
            'get_hooks_disabled',
-           'hooks_disabled'
+           'hooks_disabled',
+           'set_hook_profiling',
+           'get_hook_profiling',
+           'get_hook_stats',
+           'reset_hook_stats',
            )
 
 
@@ -36,8 +49,16 @@ __all__ = ('HookType',
 class _Hook(AutoUnload):
     """Create pre and post hooks that auto unload."""
 
-    def __init__(self, function):
-        """Verify the given function is a Function object and store it."""
+    def __init__(self, function, priority=0, stop_on_override=False):
+        """Verify the given function is a Function object and store it.
+
+        :param Function function: The function to hook.
+        :param int priority: Callbacks with a higher priority are called
+            first.
+        :param bool stop_on_override: If ``True``, the remaining callbacks
+            are skipped if the callback overrides the return value. A
+            callback can also return :data:`HOOK_STOP` to skip them.
+        """
         # Is the function to be hooked a Function instance?
         if not isinstance(function, Function):
 
@@ -49,6 +70,8 @@ class _Hook(AutoUnload):
         # Store the function
         self.callback = None
         self.function = function
+        self.priority = priority
+        self.stop_on_override = stop_on_override
 
     def __call__(self, callback):
         """Store the callback and hook it."""
@@ -56,7 +79,9 @@ class _Hook(AutoUnload):
         self.callback = callback
 
         # Hook the callback to the Function
-        self.function.add_hook(self.hook_type, self.callback)
+        self.function.add_hook(
+            self.hook_type, self.callback, self.priority,
+            self.stop_on_override)
 
         # Return the callback
         return self.callback
@@ -83,6 +108,30 @@ class PostHook(_Hook):
     hook_type = HookType.POST
 
 
+class DeferredPostHook(_Hook):
+    """Decorator class used to create deferred post hooks that auto unload.
+
+    The callback is called at the end of the frame with a list of
+    ``(<args>, <return value>)`` tuples of all calls in that frame. It can't
+    modify the arguments or the return value.
+
+    Pointers (including ``this``) are passed as integers. The objects they
+    point to have usually been freed at the end of the frame, so they must
+    not be dereferenced.
+    """
+
+    hook_type = HookType.POST_DEFERRED
+
+    def __init__(self, function, priority=0):
+        """Verify the given function is a Function object and store it.
+
+        :param Function function: The function to hook.
+        :param int priority: Callbacks with a higher priority are called
+            first.
+        """
+        super().__init__(function, priority)
+
+
 # =============================================================================
 # >> FUNCTIONS
 # =============================================================================
@@ -12,6 +12,7 @@ from core import GameConfigObj
 from memory import Convention
 from memory import DataType
 from memory import EXPOSED_CLASSES
+from memory import NativeAttribute
 from memory import TYPE_SIZES
 from memory import alloc
 from memory import find_binary
@@ -41,6 +42,25 @@ __all__ = ('CustomType',
 # =============================================================================
 manager_logger = memory_logger.manager
 
+# Attribute types that are accessed by NativeAttribute descriptors
+_NATIVE_ATTRIBUTE_TYPES = {
+    Type.BOOL: DataType.BOOL,
+    Type.CHAR: DataType.CHAR,
+    Type.UCHAR: DataType.UCHAR,
+    Type.SHORT: DataType.SHORT,
+    Type.USHORT: DataType.USHORT,
+    Type.INT: DataType.INT,
+    Type.UINT: DataType.UINT,
+    Type.LONG: DataType.LONG,
+    Type.ULONG: DataType.ULONG,
+    Type.LONG_LONG: DataType.LONG_LONG,
+    Type.ULONG_LONG: DataType.ULONG_LONG,
+    Type.FLOAT: DataType.FLOAT,
+    Type.DOUBLE: DataType.DOUBLE,
+    Type.POINTER: DataType.POINTER,
+    Type.STRING_POINTER: DataType.STRING,
+}
+
 
 # =============================================================================
 # >> CustomType
@@ -73,8 +93,13 @@ class CustomType(BasePointer):
     # Optional -- will be called when an instance of the type is deleted
     _destructor = None
 
-    def __init__(self, *args, wrap=False, auto_dealloc=True):
-        """Initialize the custom type."""
+    def __init__(self, *args, wrap=False, auto_dealloc=True, arena=False):
+        """Initialize the custom type.
+
+        If ``arena`` is True, the instance is allocated from the frame arena
+        and released at the end of the current frame. The destructor is not
+        called in that case.
+        """
         # _manager must be an instance of TypeManager. Otherwise the type
         # wasn't registered by a TypeManager.
         if not isinstance(self._manager, TypeManager):
@@ -110,8 +135,8 @@ class CustomType(BasePointer):
                     'In order to create an instance _size is required.')
 
             # Allocate some space
-            super().__init__(alloc(self._size, False))
-            self.auto_dealloc = auto_dealloc
+            super().__init__(alloc(self._size, False, arena))
+            self.auto_dealloc = auto_dealloc and not arena
 
             # Optionally, call a constructor
             if self._constructor is not None:
@@ -297,7 +322,7 @@ class TypeManager(dict):
     def create_pipe_from_dict(self, raw_data):
         """Create a pipe from a dictionary."""
         # Prepare functions
-        funcs = parse_data(
+        funcs = tuple(parse_data(
             self,
             raw_data,
             (
@@ -309,7 +334,11 @@ class TypeManager(dict):
                 (Key.SRV_CHECK, Key.as_bool, True),
                 (Key.DOC, Key.as_str, None)
             )
-        )
+        ))
+
+        # Resolve all signatures at once
+        self._find_signatures(
+            (data[0], data[5], data[1]) for name, data in funcs)
 
         # Create the functions
         cls_dict = {}
@@ -336,6 +365,34 @@ class TypeManager(dict):
         func.__doc__ = doc
         return func
 
+    @staticmethod
+    def _find_signatures(identifiers):
+        """Resolve the signatures of the given identifiers.
+
+        Every binary is scanned only once for all of its signatures. The
+        results are cached by the binary, so looking up these signatures
+        afterwards won't scan the binary again.
+
+        This is only an optimization. Binaries that can't be found or
+        scanned are skipped, so the errors are reported when a function is
+        actually used, like before.
+
+        :param iterable identifiers: ``(binary, srv_check, identifier)``
+            tuples. Identifiers that are symbols are ignored.
+        """
+        signatures = {}
+        for binary, srv_check, identifier in identifiers:
+            if isinstance(identifier, bytes):
+                signatures.setdefault(
+                    (binary, srv_check), set()).add(identifier)
+
+        for (binary, srv_check), binary_signatures in signatures.items():
+            try:
+                find_binary(binary, srv_check).find_signatures(
+                    binary_signatures)
+            except (IOError, ValueError):
+                continue
+
     def create_type_from_file(self, type_name, f, bases=(CustomType,)):
         """Create and registers a new type from a file or URL."""
         return self.create_type_from_dict(
@@ -414,7 +471,7 @@ class TypeManager(dict):
             cls_dict[name] = self.virtual_function(*data)
 
         # Prepare functions
-        funcs = parse_data(
+        funcs = tuple(parse_data(
             self,
             raw_data.get('function', {}),
             (
@@ -424,7 +481,13 @@ class TypeManager(dict):
                 (Key.CONVENTION, Key.as_convention, Convention.THISCALL),
                 (Key.DOC, Key.as_str, None)
             )
-        )
+        ))
+
+        # Resolve all signatures at once, if the binary is already known
+        if cls_dict['_binary'] is not None:
+            self._find_signatures(
+                (cls_dict['_binary'], cls_dict['_srv_check'], data[0])
+                for name, data in funcs)
 
         # Create the functions
         for name, data in funcs:
@@ -440,6 +503,10 @@ class TypeManager(dict):
             Vector vecVal;
             bool bVal;
         """
+        # Most native types are handled in C++
+        if type_name in _NATIVE_ATTRIBUTE_TYPES:
+            return self._native_attribute(type_name, offset, 0, doc)
+
         native_type = Type.is_native(type_name)
 
         def fget(ptr):
@@ -470,6 +537,14 @@ class TypeManager(dict):
 
         return property(fget, fset, None, doc)
 
+    @staticmethod
+    def _native_attribute(type_name, offset, level, doc=None):
+        """Create a NativeAttribute descriptor for a native type."""
+        attribute = NativeAttribute(
+            _NATIVE_ATTRIBUTE_TYPES[type_name], offset, level)
+        attribute.__doc__ = doc
+        return attribute
+
     def pointer_attribute(self, type_name, offset, doc=None):
         """Create a wrapper for a pointer attribute.
 
@@ -477,6 +552,10 @@ class TypeManager(dict):
             Vector* pVec;
             bool* pBool;
         """
+        # Most native types are handled in C++
+        if type_name in _NATIVE_ATTRIBUTE_TYPES:
+            return self._native_attribute(type_name, offset, 1, doc)
+
         native_type = Type.is_native(type_name)
 
         def fget(ptr):
@@ -736,7 +815,7 @@ class TypeManager(dict):
     def create_global_pointers_from_file(self, f):
         """Create global pointers from a file."""
         # Parse pointer data
-        pointers = parse_data(
+        pointers = tuple(parse_data(
             self,
             GameConfigObj(f),
             (
@@ -746,7 +825,11 @@ class TypeManager(dict):
                 (Key.LEVEL, Key.as_int, 0),
                 (Key.SRV_CHECK, Key.as_bool, True),
             )
-        )
+        ))
+
+        # Resolve all signatures at once
+        self._find_signatures(
+            (data[0], data[4], data[1]) for name, data in pointers)
 
         # Create the global pointer objects
         for name, data in pointers:
@@ -0,0 +1,206 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <string.h>
+
+// Memory
+#include "memory_arena.h"
+#include "memory_pointer.h"
+#include "utilities/wrap_macros.h"
+
+
+// ============================================================================
+// >> CONSTANTS
+// ============================================================================
+#define FRAME_ARENA_BLOCK_SIZE (64 * 1024)
+
+// Every allocation is preceded by an AllocationHeader_t and aligned to this
+// value
+#define FRAME_ARENA_ALIGNMENT 8
+
+// Marks the start of an allocation
+#define FRAME_ARENA_MAGIC 0x41524E41
+
+// Released memory is filled with this value if poisoning is enabled
+#define FRAME_ARENA_POISON 0xDD
+
+
+// ============================================================================
+// >> AllocationHeader_t
+// ============================================================================
+struct AllocationHeader_t
+{
+	unsigned int m_uiSize;
+	unsigned int m_uiMagic;
+};
+
+
+// ============================================================================
+// >> GLOBAL VARIABLES
+// ============================================================================
+CFrameArena g_FrameArena;
+
+
+// ============================================================================
+// >> CFrameArena
+// ============================================================================
+CFrameArena::CFrameArena()
+{
+	m_bPoison = false;
+	m_uiCurrent = 0;
+}
+
+CFrameArena::~CFrameArena()
+{
+	for (std::vector<Block_t>::iterator it=m_Blocks.begin(); it != m_Blocks.end(); ++it)
+		UTIL_Dealloc(it->m_pData);
+}
+
+void* CFrameArena::Alloc(size_t uiSize)
+{
+	size_t uiTotal = (uiSize + FRAME_ARENA_ALIGNMENT + FRAME_ARENA_ALIGNMENT - 1) & ~(FRAME_ARENA_ALIGNMENT - 1);
+
+	// Look for a block with enough space left. Blocks that are skipped are
+	// not used again before the next reset.
+	while (m_uiCurrent < m_Blocks.size() && m_Blocks[m_uiCurrent].m_uiSize - m_Blocks[m_uiCurrent].m_uiUsed < uiTotal)
+		m_uiCurrent++;
+
+	if (m_uiCurrent == m_Blocks.size())
+	{
+		Block_t block;
+		block.m_uiSize = uiTotal > FRAME_ARENA_BLOCK_SIZE ? uiTotal : FRAME_ARENA_BLOCK_SIZE;
+		block.m_pData = (unsigned char *) UTIL_Alloc(block.m_uiSize);
+		block.m_uiUsed = 0;
+		m_Blocks.push_back(block);
+	}
+
+	Block_t& block = m_Blocks[m_uiCurrent];
+	unsigned char* pAllocation = block.m_pData + block.m_uiUsed;
+	block.m_uiUsed += uiTotal;
+
+	AllocationHeader_t* pHeader = (AllocationHeader_t *) pAllocation;
+	pHeader->m_uiSize = (unsigned int) uiSize;
+	pHeader->m_uiMagic = FRAME_ARENA_MAGIC;
+	pAllocation += FRAME_ARENA_ALIGNMENT;
+	memset(pAllocation, 0, uiSize);
+	return pAllocation;
+}
+
+void CFrameArena::Reset()
+{
+	for (std::vector<Block_t>::iterator it=m_Blocks.begin(); it != m_Blocks.end(); ++it)
+	{
+		if (m_bPoison)
+			memset(it->m_pData, FRAME_ARENA_POISON, it->m_uiUsed);
+
+		it->m_uiUsed = 0;
+	}
+
+	m_uiCurrent = 0;
+}
+
+CFrameArena::Block_t* CFrameArena::FindBlock(unsigned long ulAddr)
+{
+	for (std::vector<Block_t>::iterator it=m_Blocks.begin(); it != m_Blocks.end(); ++it)
+	{
+		unsigned long ulStart = (unsigned long) it->m_pData;
+		if (ulAddr >= ulStart && ulAddr < ulStart + it->m_uiSize)
+			return &(*it);
+	}
+
+	return NULL;
+}
+
+bool CFrameArena::IsLive(unsigned long ulAddr)
+{
+	Block_t* pBlock = FindBlock(ulAddr);
+	return pBlock && ulAddr < (unsigned long) pBlock->m_pData + pBlock->m_uiUsed;
+}
+
+bool CFrameArena::GetAllocationSize(unsigned long ulAddr, size_t& uiSize)
+{
+	Block_t* pBlock = FindBlock(ulAddr);
+	if (!pBlock)
+		return false;
+
+	// Allocations start behind their header at an aligned offset of the block
+	unsigned long ulOffset = ulAddr - (unsigned long) pBlock->m_pData;
+	if (ulOffset < FRAME_ARENA_ALIGNMENT || ulOffset % FRAME_ARENA_ALIGNMENT != 0 || ulOffset > pBlock->m_uiUsed)
+		return false;
+
+	AllocationHeader_t* pHeader = (AllocationHeader_t *) (ulAddr - FRAME_ARENA_ALIGNMENT);
+	if (pHeader->m_uiMagic != FRAME_ARENA_MAGIC || pHeader->m_uiSize > pBlock->m_uiUsed - ulOffset)
+		return false;
+
+	uiSize = pHeader->m_uiSize;
+	return true;
+}
+
+bool CFrameArena::Owns(unsigned long ulAddr)
+{
+	return FindBlock(ulAddr) != NULL;
+}
+
+CPointer* CFrameArena::Persist(CPointer* pPtr)
+{
+	size_t uiSize;
+	if (!GetAllocationSize(pPtr->m_ulAddr, uiSize))
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Pointer is not the start of an allocation of the current frame.")
+
+	CPointer* pResult = ::Alloc(uiSize);
+	memcpy((void *) pResult->m_ulAddr, (void *) pPtr->m_ulAddr, uiSize);
+	return pResult;
+}
+
+size_t CFrameArena::GetUsed()
+{
+	size_t uiUsed = 0;
+	for (std::vector<Block_t>::iterator it=m_Blocks.begin(); it != m_Blocks.end(); ++it)
+		uiUsed += it->m_uiUsed;
+
+	return uiUsed;
+}
+
+size_t CFrameArena::GetCapacity()
+{
+	size_t uiCapacity = 0;
+	for (std::vector<Block_t>::iterator it=m_Blocks.begin(); it != m_Blocks.end(); ++it)
+		uiCapacity += it->m_uiSize;
+
+	return uiCapacity;
+}
+
+
+// ============================================================================
+// >> FUNCTIONS
+// ============================================================================
+CFrameArena* GetFrameArena()
+{
+	return &g_FrameArena;
+}
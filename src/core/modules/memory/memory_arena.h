@@ -0,0 +1,104 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_ARENA_H
+#define _MEMORY_ARENA_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <stddef.h>
+#include <vector>
+
+
+// ============================================================================
+// >> FORWARD DECLARATIONS
+// ============================================================================
+class CPointer;
+
+
+// ============================================================================
+// >> CFrameArena
+// ============================================================================
+// Allocations are carved out of larger blocks and all of them are released
+// at once at the end of every GameFrame. The blocks are kept for the next
+// frame.
+class CFrameArena
+{
+public:
+	CFrameArena();
+	~CFrameArena();
+
+	// Returns a zeroed memory block that is valid until the next reset
+	void* Alloc(size_t uiSize);
+
+	// Releases all allocations. If poisoning is enabled, the released memory
+	// is overwritten, so it's easier to detect if it's still being used.
+	void Reset();
+
+	// Returns true if the address belongs to an allocation of this frame
+	bool IsLive(unsigned long ulAddr);
+
+	// Returns true if the address belongs to one of the blocks
+	bool Owns(unsigned long ulAddr);
+
+	// Copies an allocation of this frame to a regular memory block, so it can
+	// be used after the frame has ended
+	CPointer* Persist(CPointer* pPtr);
+
+	size_t GetUsed();
+	size_t GetCapacity();
+
+private:
+	struct Block_t
+	{
+		unsigned char*	m_pData;
+		size_t			m_uiSize;
+		size_t			m_uiUsed;
+	};
+
+	Block_t* FindBlock(unsigned long ulAddr);
+
+	// Returns false if the address isn't the start of a live allocation
+	bool GetAllocationSize(unsigned long ulAddr, size_t& uiSize);
+
+public:
+	bool m_bPoison;
+
+private:
+	std::vector<Block_t>	m_Blocks;
+
+	// Index of the block that is currently used for allocations
+	size_t					m_uiCurrent;
+};
+
+
+// ============================================================================
+// >> FUNCTIONS
+// ============================================================================
+CFrameArena* GetFrameArena();
+
+#endif // _MEMORY_ARENA_H
@@ -0,0 +1,137 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+// Memory
+#include "memory_attribute.h"
+#include "memory_utilities.h"
+
+
+// ============================================================================
+// >> CNativeAttribute
+// ============================================================================
+CNativeAttribute::CNativeAttribute(DataType_t eType, int iOffset, unsigned int uiLevel /* = 0 */)
+{
+	if (eType == DATA_TYPE_VOID)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Attributes can't be of type void.")
+
+	m_eType = eType;
+	m_iOffset = iOffset;
+	m_uiLevel = uiLevel;
+}
+
+unsigned long CNativeAttribute::GetValueAddress(CPointer* pPtr, object oInstance, bool bAllocate)
+{
+	pPtr->Validate();
+	unsigned long ulAddr = pPtr->m_ulAddr + m_iOffset;
+	for (unsigned int i=0; i < m_uiLevel; i++)
+	{
+		unsigned long ulNext = GetPtrHelper(ulAddr);
+
+		// Allocate space for the value if the last pointer is NULL. The
+		// instance keeps a reference, so it lives as long as the instance.
+		if (!ulNext && bAllocate && i == m_uiLevel - 1)
+		{
+			CPointer* pAllocated = Alloc(GetDataTypeSize(m_eType, 1));
+			object oAllocated = object(boost::shared_ptr<CPointer>(pAllocated));
+			oInstance.attr("_allocated_pointers").attr("add")(oAllocated);
+
+			CPointer(ulAddr).Set<unsigned long>(pAllocated->m_ulAddr);
+			ulNext = pAllocated->m_ulAddr;
+		}
+
+		ulAddr = ulNext;
+	}
+
+	return ulAddr;
+}
+
+object CNativeAttribute::Get(object oInstance)
+{
+	CPointer value(GetValueAddress(ExtractPointer(oInstance), oInstance, false));
+	switch(m_eType)
+	{
+		case DATA_TYPE_BOOL:		return object(value.Get<bool>());
+		case DATA_TYPE_CHAR:		return object(value.Get<char>());
+		case DATA_TYPE_UCHAR:		return object(value.Get<unsigned char>());
+		case DATA_TYPE_SHORT:		return object(value.Get<short>());
+		case DATA_TYPE_USHORT:		return object(value.Get<unsigned short>());
+		case DATA_TYPE_INT:			return object(value.Get<int>());
+		case DATA_TYPE_UINT:		return object(value.Get<unsigned int>());
+		case DATA_TYPE_LONG:		return object(value.Get<long>());
+		case DATA_TYPE_ULONG:		return object(value.Get<unsigned long>());
+		case DATA_TYPE_LONG_LONG:	return object(value.Get<long long>());
+		case DATA_TYPE_ULONG_LONG:	return object(value.Get<unsigned long long>());
+		case DATA_TYPE_FLOAT:		return object(value.Get<float>());
+		case DATA_TYPE_DOUBLE:		return object(value.Get<double>());
+		case DATA_TYPE_POINTER:		return object(CPointer(value.Get<unsigned long>()));
+		case DATA_TYPE_STRING:		return object(value.Get<const char*>());
+		default: BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown data type.")
+	}
+	return object();
+}
+
+void CNativeAttribute::Set(object oInstance, object oValue)
+{
+	CPointer value(GetValueAddress(ExtractPointer(oInstance), oInstance, true));
+	switch(m_eType)
+	{
+		case DATA_TYPE_BOOL:		value.Set<bool>(extract<bool>(oValue)); break;
+		case DATA_TYPE_CHAR:		value.Set<char>(extract<char>(oValue)); break;
+		case DATA_TYPE_UCHAR:		value.Set<unsigned char>(extract<unsigned char>(oValue)); break;
+		case DATA_TYPE_SHORT:		value.Set<short>(extract<short>(oValue)); break;
+		case DATA_TYPE_USHORT:		value.Set<unsigned short>(extract<unsigned short>(oValue)); break;
+		case DATA_TYPE_INT:			value.Set<int>(extract<int>(oValue)); break;
+		case DATA_TYPE_UINT:		value.Set<unsigned int>(extract<unsigned int>(oValue)); break;
+		case DATA_TYPE_LONG:		value.Set<long>(extract<long>(oValue)); break;
+		case DATA_TYPE_ULONG:		value.Set<unsigned long>(extract<unsigned long>(oValue)); break;
+		case DATA_TYPE_LONG_LONG:	value.Set<long long>(extract<long long>(oValue)); break;
+		case DATA_TYPE_ULONG_LONG:	value.Set<unsigned long long>(extract<unsigned long long>(oValue)); break;
+		case DATA_TYPE_FLOAT:		value.Set<float>(extract<float>(oValue)); break;
+		case DATA_TYPE_DOUBLE:		value.Set<double>(extract<double>(oValue)); break;
+		case DATA_TYPE_POINTER:		value.SetPtr(oValue); break;
+		case DATA_TYPE_STRING:		value.Set<const char*>(extract<const char*>(oValue)); break;
+		default: BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown data type.")
+	}
+}
+
+object CNativeAttribute::__get__(object oSelf, object oInstance, object oOwner)
+{
+	// Accessed through the class
+	if (oInstance.is_none())
+		return oSelf;
+
+	CNativeAttribute& attribute = extract<CNativeAttribute&>(oSelf);
+	return attribute.Get(oInstance);
+}
+
+void CNativeAttribute::__set__(object oSelf, object oInstance, object oValue)
+{
+	CNativeAttribute& attribute = extract<CNativeAttribute&>(oSelf);
+	attribute.Set(oInstance, oValue);
+}
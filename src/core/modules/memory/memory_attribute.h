@@ -0,0 +1,71 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_ATTRIBUTE_H
+#define _MEMORY_ATTRIBUTE_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+// DynamicHooks
+#include "convention.h"
+
+// Memory
+#include "memory_pointer.h"
+
+// Boost.Python
+#include "boost/python.hpp"
+using namespace boost::python;
+
+
+// ============================================================================
+// >> CNativeAttribute
+// ============================================================================
+// A descriptor that reads/writes a native value at a fixed offset of a
+// pointer. If a level is given, the pointer at the offset is dereferenced
+// that many times before the value is accessed.
+class CNativeAttribute
+{
+public:
+	CNativeAttribute(DataType_t eType, int iOffset, unsigned int uiLevel = 0);
+
+	object Get(object oInstance);
+	void Set(object oInstance, object oValue);
+
+	// Descriptor protocol
+	static object __get__(object oSelf, object oInstance, object oOwner);
+	static void __set__(object oSelf, object oInstance, object oValue);
+
+private:
+	unsigned long GetValueAddress(CPointer* pPtr, object oInstance, bool bAllocate);
+
+public:
+	DataType_t		m_eType;
+	int				m_iOffset;
+	unsigned int	m_uiLevel;
+};
+
+#endif // _MEMORY_ATTRIBUTE_H
@@ -0,0 +1,272 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <string.h>
+#include <vector>
+
+// Memory
+#include "memory_deferred_hooks.h"
+#include "memory_arena.h"
+#include "utilities/call_python.h"
+#include "utilities/wrap_macros.h"
+
+
+// ============================================================================
+// >> GLOBAL VARIABLES
+// ============================================================================
+CDeferredHookBuffer g_DeferredHookBuffer;
+
+
+// ============================================================================
+// >> HELPER FUNCTIONS
+// ============================================================================
+void CaptureValue(DataType_t type, void* pValue, unsigned long long* pResult)
+{
+	*pResult = 0;
+	switch(type)
+	{
+		case DATA_TYPE_VOID: break;
+		case DATA_TYPE_STRING:
+		{
+			// The string might not exist anymore at the end of the frame
+			const char* szValue = *(const char **) pValue;
+			if (szValue)
+			{
+				size_t uiSize = strlen(szValue) + 1;
+				char* szCopy = (char *) GetFrameArena()->Alloc(uiSize);
+				memcpy(szCopy, szValue, uiSize);
+				*(const char **) pResult = szCopy;
+			}
+		} break;
+		default: memcpy(pResult, pValue, GetDataTypeSize(type, 1));
+	}
+}
+
+template<class T>
+object ValueToPython(unsigned long long* pValue)
+{
+	return object(*(T *) pValue);
+}
+
+object ValueToPython(DataType_t type, unsigned long long* pValue)
+{
+	switch(type)
+	{
+		case DATA_TYPE_BOOL:		return ValueToPython<bool>(pValue);
+		case DATA_TYPE_CHAR:		return ValueToPython<char>(pValue);
+		case DATA_TYPE_UCHAR:		return ValueToPython<unsigned char>(pValue);
+		case DATA_TYPE_SHORT:		return ValueToPython<short>(pValue);
+		case DATA_TYPE_USHORT:		return ValueToPython<unsigned short>(pValue);
+		case DATA_TYPE_INT:			return ValueToPython<int>(pValue);
+		case DATA_TYPE_UINT:		return ValueToPython<unsigned int>(pValue);
+		case DATA_TYPE_LONG:		return ValueToPython<long>(pValue);
+		case DATA_TYPE_ULONG:		return ValueToPython<unsigned long>(pValue);
+		case DATA_TYPE_LONG_LONG:	return ValueToPython<long long>(pValue);
+		case DATA_TYPE_ULONG_LONG:	return ValueToPython<unsigned long long>(pValue);
+		case DATA_TYPE_FLOAT:		return ValueToPython<float>(pValue);
+		case DATA_TYPE_DOUBLE:		return ValueToPython<double>(pValue);
+		// The object is most likely gone at the end of the frame, so only
+		// the address is passed
+		case DATA_TYPE_POINTER:		return ValueToPython<unsigned long>(pValue);
+		case DATA_TYPE_STRING:		return ValueToPython<const char *>(pValue);
+	}
+	return object();
+}
+
+object RecordToPython(DeferredHookRecord_t& record)
+{
+	ICallingConvention* pConvention = record.m_pHook->m_pCallingConvention;
+
+	unsigned int uiArgs = (unsigned int) pConvention->m_vecArgTypes.size();
+	if (uiArgs > DEFERRED_HOOK_MAX_ARGS)
+		uiArgs = DEFERRED_HOOK_MAX_ARGS;
+
+	list args;
+	for (unsigned int i=0; i < uiArgs; i++)
+		args.append(ValueToPython(pConvention->m_vecArgTypes[i], &record.m_Args[i]));
+
+	return make_tuple(tuple(args), ValueToPython(pConvention->m_returnType, &record.m_ReturnValue));
+}
+
+
+// ============================================================================
+// >> CDeferredHookBuffer
+// ============================================================================
+CDeferredHookBuffer::CDeferredHookBuffer()
+{
+	m_pRecords = NULL;
+	m_uiFirst = 0;
+	m_uiCount = 0;
+	m_uiDropped = 0;
+}
+
+CDeferredHookBuffer::~CDeferredHookBuffer()
+{
+	delete[] m_pRecords;
+}
+
+void CDeferredHookBuffer::Capture(CHook* pHook)
+{
+	// Allocated on first use, so servers without deferred post-hooks don't
+	// pay for it
+	if (!m_pRecords)
+		m_pRecords = new DeferredHookRecord_t[DEFERRED_HOOK_BUFFER_SIZE];
+
+	if (m_uiCount == DEFERRED_HOOK_BUFFER_SIZE)
+	{
+		m_uiFirst = (m_uiFirst + 1) % DEFERRED_HOOK_BUFFER_SIZE;
+		m_uiCount--;
+		m_uiDropped++;
+	}
+
+	DeferredHookRecord_t& record = m_pRecords[(m_uiFirst + m_uiCount) % DEFERRED_HOOK_BUFFER_SIZE];
+	m_uiCount++;
+
+	ICallingConvention* pConvention = pHook->m_pCallingConvention;
+	record.m_pHook = pHook;
+
+	// CFunction::AddHook rejects functions with more arguments, but the
+	// record must never overflow
+	unsigned int uiArgs = (unsigned int) pConvention->m_vecArgTypes.size();
+	if (uiArgs > DEFERRED_HOOK_MAX_ARGS)
+		uiArgs = DEFERRED_HOOK_MAX_ARGS;
+
+	for (unsigned int i=0; i < uiArgs; i++)
+		CaptureValue(pConvention->m_vecArgTypes[i], pConvention->GetArgumentPtr(i, pHook->m_pRegisters), &record.m_Args[i]);
+
+	if (pConvention->m_returnType == DATA_TYPE_VOID)
+		record.m_ReturnValue = 0;
+	else
+		CaptureValue(pConvention->m_returnType, pConvention->GetReturnPtr(pHook->m_pRegisters), &record.m_ReturnValue);
+}
+
+void CDeferredHookBuffer::Flush()
+{
+	for (int iRound=0; iRound < DEFERRED_HOOK_MAX_ROUNDS && m_uiCount; iRound++)
+	{
+		// Convert all records before calling any callback, because the
+		// callbacks might capture new calls
+		std::vector<CHook *> hooks;
+		boost::unordered_map<CHook *, list> batches;
+		for (unsigned int uiCount=m_uiCount; uiCount > 0; uiCount--)
+		{
+			DeferredHookRecord_t& record = m_pRecords[m_uiFirst];
+			m_uiFirst = (m_uiFirst + 1) % DEFERRED_HOOK_BUFFER_SIZE;
+			m_uiCount--;
+
+			if (!record.m_pHook)
+				continue;
+
+			BEGIN_BOOST_PY()
+				if (batches.find(record.m_pHook) == batches.end())
+					hooks.push_back(record.m_pHook);
+
+				batches[record.m_pHook].append(RecordToPython(record));
+			END_BOOST_PY_NORET()
+		}
+
+		for (std::vector<CHook *>::iterator it=hooks.begin(); it != hooks.end(); ++it)
+		{
+			// The hook might have been removed by a previous callback
+			CHookCallbacks* pCallbacks = GetHookCallbacks(*it);
+			if (!pCallbacks)
+				continue;
+
+			CallbackSnapshot callbacks = pCallbacks->GetCallbacks(HOOKTYPE_POST_DEFERRED);
+			if (!callbacks)
+				continue;
+
+			HookStatsPtr pStats;
+			double dStartTime = 0;
+			if (g_HookProfiling)
+			{
+				pStats = pCallbacks->GetStats();
+				dStartTime = GetProfilerTime();
+			}
+
+			list batch = batches[*it];
+			for (CallbackVector::const_iterator callback=callbacks->begin(); callback != callbacks->end(); ++callback)
+			{
+				BEGIN_BOOST_PY()
+					double dCallbackStartTime = pStats ? GetProfilerTime() : 0;
+					callback->m_oCallback(batch);
+
+					if (pStats && IsCallbackRegistered(*it, HOOKTYPE_POST_DEFERRED, callbacks, callback->m_oCallback.ptr()))
+					{
+						pStats->GetCallbackStats(HOOKTYPE_POST_DEFERRED, callback->m_oCallback.ptr()).Record(
+							GetProfilerTime() - dCallbackStartTime, false);
+					}
+				END_BOOST_PY_NORET()
+			}
+
+			if (pStats)
+				pStats->GetDispatchStats(HOOKTYPE_POST_DEFERRED).Record(GetProfilerTime() - dStartTime, false);
+		}
+	}
+
+	// Whatever is left refers to strings in the frame arena, which is about
+	// to be reset
+	if (m_uiCount)
+	{
+		m_uiDropped += m_uiCount;
+		Discard();
+	}
+
+	if (m_uiDropped)
+	{
+		PythonLog(2, "%u deferred post-hook calls have been dropped in this frame.", m_uiDropped);
+		m_uiDropped = 0;
+	}
+}
+
+void CDeferredHookBuffer::Discard(CHook* pHook /* = NULL */)
+{
+	if (!pHook)
+	{
+		m_uiFirst = 0;
+		m_uiCount = 0;
+		return;
+	}
+
+	for (unsigned int i=0; i < m_uiCount; i++)
+	{
+		DeferredHookRecord_t& record = m_pRecords[(m_uiFirst + i) % DEFERRED_HOOK_BUFFER_SIZE];
+		if (record.m_pHook == pHook)
+			record.m_pHook = NULL;
+	}
+}
+
+
+// ============================================================================
+// >> FUNCTIONS
+// ============================================================================
+CDeferredHookBuffer* GetDeferredHookBuffer()
+{
+	return &g_DeferredHookBuffer;
+}
@@ -0,0 +1,102 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_DEFERRED_HOOKS_H
+#define _MEMORY_DEFERRED_HOOKS_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include "memory_hooks.h"
+
+
+// ============================================================================
+// >> CONSTANTS
+// ============================================================================
+// Maximum number of calls that are kept until the end of the frame. If more
+// calls are captured, the oldest ones are overwritten.
+#define DEFERRED_HOOK_BUFFER_SIZE 4096
+
+// Maximum number of arguments a function with deferred post-hooks can have
+#define DEFERRED_HOOK_MAX_ARGS STACK_DATA_CACHE_SIZE
+
+// Maximum number of times the buffer is emptied per frame. Calls that are
+// captured while the callbacks are delivered are delivered in the next round.
+#define DEFERRED_HOOK_MAX_ROUNDS 4
+
+
+// ============================================================================
+// >> DeferredHookRecord_t
+// ============================================================================
+// Raw copy of the arguments and the return value of a call. Strings are
+// copied to the frame arena. Pointers are only kept as addresses.
+struct DeferredHookRecord_t
+{
+	// NULL if the hook has been removed
+	CHook*				m_pHook;
+	unsigned long long	m_Args[DEFERRED_HOOK_MAX_ARGS];
+	unsigned long long	m_ReturnValue;
+};
+
+
+// ============================================================================
+// >> CDeferredHookBuffer
+// ============================================================================
+class CDeferredHookBuffer
+{
+public:
+	CDeferredHookBuffer();
+	~CDeferredHookBuffer();
+
+	// Copies the arguments and the return value of the current call
+	void Capture(CHook* pHook);
+
+	// Passes all captured calls to the deferred post-hooks. Every callback is
+	// called once per hook with a list of (<args>, <return value>) tuples.
+	void Flush();
+
+	// Discards the captured calls of the given hook or of all hooks if it's
+	// NULL
+	void Discard(CHook* pHook = NULL);
+
+private:
+	DeferredHookRecord_t* m_pRecords;
+
+	unsigned int	m_uiFirst;
+	unsigned int	m_uiCount;
+
+	// Number of calls that have been overwritten or discarded since the last
+	// flush
+	unsigned int	m_uiDropped;
+};
+
+
+// ============================================================================
+// >> FUNCTIONS
+// ============================================================================
+CDeferredHookBuffer* GetDeferredHookBuffer();
+
+#endif // _MEMORY_DEFERRED_HOOKS_H
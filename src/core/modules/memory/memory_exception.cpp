@@ -48,6 +48,9 @@ int ExceptionHandler(_EXCEPTION_POINTERS* info, DWORD code)
 		EXCEPTION_RECORD* record = info->ExceptionRecord;
 		char* exc_message;
 
+		// The GIL might have been released to call a thread-safe function
+		PyGILState_STATE gil_state = PyGILState_Ensure();
+
 		if (record->ExceptionInformation[0] == 0)
 			exc_message = "Access violation while reading address '%u'.";
 		else if (record->ExceptionInformation[0] == 1)
@@ -55,12 +58,18 @@ int ExceptionHandler(_EXCEPTION_POINTERS* info, DWORD code)
 		else if (record->ExceptionInformation[0] == 8)
 			exc_message = "Access violation while executing address '%u'.";
 		else
-			BOOST_RAISE_EXCEPTION(
+			exc_message = NULL;
+
+		if (exc_message)
+			PyErr_Format(PyExc_RuntimeError, exc_message, record->ExceptionInformation[1]);
+		else
+			PyErr_Format(
 				PyExc_RuntimeError,
 				"Unknown access violation '%i' at address '%u'.", 
-				record->ExceptionInformation[0], record->ExceptionInformation[1])
+				record->ExceptionInformation[0], record->ExceptionInformation[1]);
 
-		BOOST_RAISE_EXCEPTION(PyExc_RuntimeError, exc_message, record->ExceptionInformation[1])
+		PyGILState_Release(gil_state);
+		throw_error_already_set();
 	}
 
 	return EXCEPTION_CONTINUE_SEARCH;
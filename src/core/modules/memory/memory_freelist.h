@@ -0,0 +1,114 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_FREELIST_H
+#define _MEMORY_FREELIST_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <stdlib.h>
+#include <new>
+
+
+// ============================================================================
+// >> CFreeList
+// ============================================================================
+// Recycles memory blocks of a fixed size. Blocks are allocated in chunks and
+// never returned to the system, so this should only be used for small objects
+// that are created and destroyed very often. Not thread-safe, so it must only
+// be used while holding the GIL.
+template<size_t Size>
+class CFreeList
+{
+public:
+	static void* Alloc()
+	{
+		if (!s_pFree)
+			Grow();
+
+		Block_t* pBlock = s_pFree;
+		s_pFree = pBlock->m_pNext;
+		return pBlock;
+	}
+
+	static void Free(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		Block_t* pBlock = (Block_t *) ptr;
+		pBlock->m_pNext = s_pFree;
+		s_pFree = pBlock;
+	}
+
+private:
+	union Block_t
+	{
+		Block_t*	m_pNext;
+		double		m_Align;
+		char		m_Data[Size];
+	};
+
+	static void Grow()
+	{
+		Block_t* pChunk = (Block_t *) malloc(sizeof(Block_t) * CHUNK_SIZE);
+		if (!pChunk)
+			throw std::bad_alloc();
+
+		for (int i=0; i < CHUNK_SIZE; i++)
+			Free(&pChunk[i]);
+	}
+
+	enum { CHUNK_SIZE = 256 };
+	static Block_t* s_pFree;
+};
+
+template<size_t Size>
+typename CFreeList<Size>::Block_t* CFreeList<Size>::s_pFree = NULL;
+
+
+// ============================================================================
+// >> DECLARE_FREELIST_ALLOCATOR
+// ============================================================================
+// Adds a class specific operator new/delete that uses a CFreeList. Derived
+// classes with a different size fall back to the global operators.
+#define DECLARE_FREELIST_ALLOCATOR(type) \
+	static void* operator new(size_t size) \
+	{ \
+		if (size != sizeof(type)) \
+			return ::operator new(size); \
+		return CFreeList<sizeof(type)>::Alloc(); \
+	} \
+	static void operator delete(void* ptr, size_t size) \
+	{ \
+		if (size != sizeof(type)) \
+			::operator delete(ptr); \
+		else \
+			CFreeList<sizeof(type)>::Free(ptr); \
+	}
+
+#endif // _MEMORY_FREELIST_H
@@ -35,6 +35,7 @@
 #include "memory_function.h"
 #include "memory_utilities.h"
 #include "memory_hooks.h"
+#include "memory_deferred_hooks.h"
 
 // DynamicHooks
 #include "conventions/x86MsCdecl.h"
@@ -49,15 +50,105 @@
 
 
 // ============================================================================
-// >> EXTERNALS
+// >> GLOBAL VARIABLES
 // ============================================================================
-extern std::map<CHook *, std::map<HookType_t, std::list<object> > > g_mapCallbacks;
+#ifdef _WIN32
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
+// Every thread gets its own VM, so functions can also be called from other threads
+THREAD_LOCAL DCCallVM* g_pCallVM = NULL;
 
 
 // ============================================================================
-// >> GLOBAL VARIABLES
+// >> GetCallVM
 // ============================================================================
-DCCallVM* g_pCallVM = dcNewCallVM(4096);
+inline DCCallVM* GetCallVM()
+{
+	if (!g_pCallVM)
+		g_pCallVM = dcNewCallVM(4096);
+
+	return g_pCallVM;
+}
+
+
+// ============================================================================
+// >> CReleaseGIL
+// ============================================================================
+// Releases the GIL for the lifetime of the object, if requested
+class CReleaseGIL
+{
+public:
+	CReleaseGIL(bool bRelease)
+	{ m_pThreadState = bRelease ? PyEval_SaveThread() : NULL; }
+
+	~CReleaseGIL()
+	{
+		if (m_pThreadState)
+			PyEval_RestoreThread(m_pThreadState);
+	}
+
+private:
+	PyThreadState* m_pThreadState;
+};
+
+
+// ============================================================================
+// >> Argument pushers
+// ============================================================================
+template<class T, class DCType, void (*PushFn)(DCCallVM*, DCType)>
+void PushArgument(DCCallVM* vm, PyObject* pArg)
+{
+	T value = extract<T>(pArg);
+	PushFn(vm, value);
+}
+
+void PushPointerArgument(DCCallVM* vm, PyObject* pArg)
+{
+	unsigned long ulAddr = 0;
+	if (pArg != Py_None)
+		ulAddr = ExtractPointer(object(handle<>(borrowed(pArg))))->m_ulAddr;
+
+	dcArgPointer(vm, ulAddr);
+}
+
+void PushStringArgument(DCCallVM* vm, PyObject* pArg)
+{
+	char* szValue = extract<char *>(pArg);
+	dcArgPointer(vm, (unsigned long) (void *) szValue);
+}
+
+void PushUnknownArgument(DCCallVM* vm, PyObject* pArg)
+{
+	BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Unknown argument type.")
+}
+
+ArgPusherFn GetArgPusher(DataType_t eType)
+{
+	switch(eType)
+	{
+		case DATA_TYPE_BOOL:		return &PushArgument<bool, DCbool, dcArgBool>;
+		case DATA_TYPE_CHAR:		return &PushArgument<char, DCchar, dcArgChar>;
+		case DATA_TYPE_UCHAR:		return &PushArgument<unsigned char, DCchar, dcArgChar>;
+		case DATA_TYPE_SHORT:		return &PushArgument<short, DCshort, dcArgShort>;
+		case DATA_TYPE_USHORT:		return &PushArgument<unsigned short, DCshort, dcArgShort>;
+		case DATA_TYPE_INT:			return &PushArgument<int, DCint, dcArgInt>;
+		case DATA_TYPE_UINT:		return &PushArgument<unsigned int, DCint, dcArgInt>;
+		case DATA_TYPE_LONG:		return &PushArgument<long, DClong, dcArgLong>;
+		case DATA_TYPE_ULONG:		return &PushArgument<unsigned long, DClong, dcArgLong>;
+		case DATA_TYPE_LONG_LONG:	return &PushArgument<long long, DClonglong, dcArgLongLong>;
+		case DATA_TYPE_ULONG_LONG:	return &PushArgument<unsigned long long, DClonglong, dcArgLongLong>;
+		case DATA_TYPE_FLOAT:		return &PushArgument<float, DCfloat, dcArgFloat>;
+		case DATA_TYPE_DOUBLE:		return &PushArgument<double, DCdouble, dcArgDouble>;
+		case DATA_TYPE_POINTER:		return &PushPointerArgument;
+		case DATA_TYPE_STRING:		return &PushStringArgument;
+	}
+
+	// Raise the error when the function is called, not when it's created
+	return &PushUnknownArgument;
+}
 
 
 // ============================================================================
@@ -118,6 +209,8 @@ ICallingConvention* MakeDynamicHooksConvention(Convention_t eConv, std::vector<D
 CFunction::CFunction(unsigned long ulAddr, object oCallingConvention, object oArgs, object oReturnType)
 	:CPointer(ulAddr)
 {
+	m_bThreadSafe = false;
+
 	// Step 1: Validate and convert the argument types
 	m_tArgs = tuple(oArgs);
 
@@ -170,6 +263,9 @@ CFunction::CFunction(unsigned long ulAddr, object oCallingConvention, object oAr
 
 	// Step 4: Get the DynCall calling convention
 	m_iCallingConvention = GetDynCallConvention(m_eCallingConvention);
+
+	// Step 5: Compile the argument types
+	CompileSignature();
 }
 
 CFunction::CFunction(unsigned long ulAddr, Convention_t eCallingConvention,
@@ -179,6 +275,7 @@ CFunction::CFunction(unsigned long ulAddr, Convention_t eCallingConvention,
 	m_eCallingConvention = eCallingConvention;
 	m_iCallingConvention = iCallingConvention;
 	m_pCallingConvention = NULL;
+	m_bThreadSafe = false;
 
 	// We didn't allocate the calling convention, someone else is responsible for it.
 	m_bAllocatedCallingConvention = false;
@@ -186,6 +283,8 @@ CFunction::CFunction(unsigned long ulAddr, Convention_t eCallingConvention,
 	m_tArgs = tArgs;
 	m_eReturnType = eReturnType;
 	m_oConverter = oConverter;
+
+	CompileSignature();
 }
 
 CFunction::~CFunction()
@@ -194,7 +293,7 @@ CFunction::~CFunction()
 	if (!m_bAllocatedCallingConvention)
 		return;
 
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
+	CHook* pHook = FindHook((void *) m_ulAddr);
 
 	// DynamicHooks will take care of it for us from there.
 	if (pHook && pHook->m_pCallingConvention == m_pCallingConvention)
@@ -205,6 +304,18 @@ CFunction::~CFunction()
 	m_pCallingConvention = NULL;
 }
 
+void CFunction::CompileSignature()
+{
+	m_vecArgTypes = ObjectToDataTypeVector(m_tArgs);
+
+	m_vecArgPushers.clear();
+	m_vecArgPushers.reserve(m_vecArgTypes.size());
+	for (std::vector<DataType_t>::iterator it=m_vecArgTypes.begin(); it != m_vecArgTypes.end(); ++it)
+	{
+		m_vecArgPushers.push_back(GetArgPusher(*it));
+	}
+}
+
 bool CFunction::IsCallable()
 {
 	return (m_eCallingConvention != CONV_CUSTOM) && (m_iCallingConvention != -1);
@@ -217,21 +328,24 @@ bool CFunction::IsHookable()
 
 bool CFunction::IsHooked()
 {
-	return GetHookManager()->FindHook((void *) m_ulAddr) != NULL;
+	return FindHook((void *) m_ulAddr) != NULL;
 }
 
 CFunction* CFunction::GetTrampoline()
 {
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
+	CHook* pHook = FindHook((void *) m_ulAddr);
 	if (!pHook)
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function was not hooked.")
 
-	return new CFunction((unsigned long) pHook->m_pTrampoline, m_eCallingConvention,
+	CFunction* pTrampoline = new CFunction((unsigned long) pHook->m_pTrampoline, m_eCallingConvention,
 		m_iCallingConvention, m_tArgs, m_eReturnType, m_oConverter);
+
+	pTrampoline->m_bThreadSafe = m_bThreadSafe;
+	return pTrampoline;
 }
 
 template<class ReturnType, class Function>
-ReturnType CallHelper(Function func, DCCallVM* vm, unsigned long addr)
+ReturnType CallHelperSEH(Function func, DCCallVM* vm, unsigned long addr)
 {
 	ReturnType result;
 	TRY_SEGV()
@@ -240,126 +354,164 @@ ReturnType CallHelper(Function func, DCCallVM* vm, unsigned long addr)
 	return result;
 }
 
-void CallHelperVoid(DCCallVM* vm, unsigned long addr)
+void CallHelperVoidSEH(DCCallVM* vm, unsigned long addr)
 {
 	TRY_SEGV()
 		dcCallVoid(vm, addr);
 	EXCEPT_SEGV()
 }
 
+// The GIL can't be released in the functions above, because __try doesn't
+// allow objects that require unwinding.
+template<class ReturnType, class Function>
+ReturnType CallHelper(Function func, DCCallVM* vm, unsigned long addr, bool bReleaseGIL)
+{
+	CReleaseGIL gil(bReleaseGIL);
+	return CallHelperSEH<ReturnType>(func, vm, addr);
+}
+
+void CallHelperVoid(DCCallVM* vm, unsigned long addr, bool bReleaseGIL)
+{
+	CReleaseGIL gil(bReleaseGIL);
+	CallHelperVoidSEH(vm, addr);
+}
+
 object CFunction::Call(tuple args, dict kw)
+{
+	return Call(PySequence_Fast_ITEMS(args.ptr()), (int) PyTuple_GET_SIZE(args.ptr()));
+}
+
+object CFunction::CallTrampoline(tuple args, dict kw)
+{
+	return CallTrampoline(PySequence_Fast_ITEMS(args.ptr()), (int) PyTuple_GET_SIZE(args.ptr()));
+}
+
+object CFunction::SkipHooks(tuple args, dict kw)
+{
+	return SkipHooks(PySequence_Fast_ITEMS(args.ptr()), (int) PyTuple_GET_SIZE(args.ptr()));
+}
+
+object CFunction::Call(PyObject** ppArgs, int iNumArgs)
+{
+	Validate();
+	return CallAddress(m_ulAddr, ppArgs, iNumArgs);
+}
+
+object CFunction::CallTrampoline(PyObject** ppArgs, int iNumArgs)
+{
+	CHook* pHook = FindHook((void *) m_ulAddr);
+	if (!pHook)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function was not hooked.")
+
+	return CallAddress((unsigned long) pHook->m_pTrampoline, ppArgs, iNumArgs);
+}
+
+object CFunction::SkipHooks(PyObject** ppArgs, int iNumArgs)
+{
+	CHook* pHook = FindHook((void *) m_ulAddr);
+	if (pHook)
+		return CallAddress((unsigned long) pHook->m_pTrampoline, ppArgs, iNumArgs);
+
+	return Call(ppArgs, iNumArgs);
+}
+
+list CFunction::CallMany(object oArguments)
+{
+	Validate();
+
+	list results;
+	object iterator = object(handle<>(PyObject_GetIter(oArguments.ptr())));
+
+	// Every argument sequence reuses the compiled signature and the VM
+	PyObject* pItem;
+	while ((pItem = PyIter_Next(iterator.ptr())) != NULL)
+	{
+		object item = object(handle<>(pItem));
+		object args = object(handle<>(PySequence_Fast(pItem, "Arguments must be a sequence.")));
+		results.append(CallAddress(m_ulAddr, PySequence_Fast_ITEMS(args.ptr()), (int) PySequence_Fast_GET_SIZE(args.ptr())));
+	}
+
+	if (PyErr_Occurred())
+		throw_error_already_set();
+
+	return results;
+}
+
+object CFunction::CallAddress(unsigned long ulAddr, PyObject** ppArgs, int iNumArgs)
 {
 	if (!IsCallable())
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function is not callable.")
 
-	Validate();
-	if (len(args) != len(m_tArgs))
+	if (iNumArgs != (int) m_vecArgPushers.size())
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Number of passed arguments is not equal to the required number.")
 
 	// Reset VM and set the calling convention
-	dcReset(g_pCallVM);
-	dcMode(g_pCallVM, m_iCallingConvention);
+	DCCallVM* pVM = GetCallVM();
+	dcReset(pVM);
+	dcMode(pVM, m_iCallingConvention);
 
 	// Loop through all passed arguments and add them to the VM
-	for(int i=0; i < len(args); i++)
+	for(int i=0; i < iNumArgs; i++)
 	{
-		object arg = args[i];
-		switch(extract<DataType_t>(m_tArgs[i]))
-		{
-			case DATA_TYPE_BOOL:		dcArgBool(g_pCallVM, extract<bool>(arg)); break;
-			case DATA_TYPE_CHAR:		dcArgChar(g_pCallVM, extract<char>(arg)); break;
-			case DATA_TYPE_UCHAR:		dcArgChar(g_pCallVM, extract<unsigned char>(arg)); break;
-			case DATA_TYPE_SHORT:		dcArgShort(g_pCallVM, extract<short>(arg)); break;
-			case DATA_TYPE_USHORT:		dcArgShort(g_pCallVM, extract<unsigned short>(arg)); break;
-			case DATA_TYPE_INT:			dcArgInt(g_pCallVM, extract<int>(arg)); break;
-			case DATA_TYPE_UINT:		dcArgInt(g_pCallVM, extract<unsigned int>(arg)); break;
-			case DATA_TYPE_LONG:		dcArgLong(g_pCallVM, extract<long>(arg)); break;
-			case DATA_TYPE_ULONG:		dcArgLong(g_pCallVM, extract<unsigned long>(arg)); break;
-			case DATA_TYPE_LONG_LONG:	dcArgLongLong(g_pCallVM, extract<long long>(arg)); break;
-			case DATA_TYPE_ULONG_LONG:	dcArgLongLong(g_pCallVM, extract<unsigned long long>(arg)); break;
-			case DATA_TYPE_FLOAT:		dcArgFloat(g_pCallVM, extract<float>(arg)); break;
-			case DATA_TYPE_DOUBLE:		dcArgDouble(g_pCallVM, extract<double>(arg)); break;
-			case DATA_TYPE_POINTER:
-			{
-				unsigned long ulAddr = 0;
-				if (arg.ptr() != Py_None)
-					ulAddr = ExtractPointer(arg)->m_ulAddr;
-
-				dcArgPointer(g_pCallVM, ulAddr);
-				break;
-			} 
-			case DATA_TYPE_STRING:		dcArgPointer(g_pCallVM, (unsigned long) (void *) extract<char *>(arg)); break;
-			default:					BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Unknown argument type.")
-		}
+		m_vecArgPushers[i](pVM, ppArgs[i]);
 	}
 
 	// Call the function
 	switch(m_eReturnType)
 	{
-		case DATA_TYPE_VOID:		CallHelperVoid(g_pCallVM, m_ulAddr); break;
-		case DATA_TYPE_BOOL:		return object(CallHelper<bool>(dcCallBool, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_CHAR:		return object(CallHelper<char>(dcCallChar, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_UCHAR:		return object(CallHelper<unsigned char>(dcCallChar, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_SHORT:		return object(CallHelper<short>(dcCallShort, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_USHORT:		return object(CallHelper<unsigned short>(dcCallShort, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_INT:			return object(CallHelper<int>(dcCallInt, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_UINT:		return object(CallHelper<unsigned int>(dcCallInt, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_LONG:		return object(CallHelper<long>(dcCallLong, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_ULONG:		return object(CallHelper<unsigned long>(dcCallLong, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_LONG_LONG:	return object(CallHelper<long long>(dcCallLongLong, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_ULONG_LONG:	return object(CallHelper<unsigned long long>(dcCallLongLong, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_FLOAT:		return object(CallHelper<float>(dcCallFloat, g_pCallVM, m_ulAddr));
-		case DATA_TYPE_DOUBLE:		return object(CallHelper<double>(dcCallDouble, g_pCallVM, m_ulAddr));
+		case DATA_TYPE_VOID:		CallHelperVoid(pVM, ulAddr, m_bThreadSafe); break;
+		case DATA_TYPE_BOOL:		return object(CallHelper<bool>(dcCallBool, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_CHAR:		return object(CallHelper<char>(dcCallChar, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_UCHAR:		return object(CallHelper<unsigned char>(dcCallChar, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_SHORT:		return object(CallHelper<short>(dcCallShort, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_USHORT:		return object(CallHelper<unsigned short>(dcCallShort, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_INT:			return object(CallHelper<int>(dcCallInt, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_UINT:		return object(CallHelper<unsigned int>(dcCallInt, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_LONG:		return object(CallHelper<long>(dcCallLong, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_ULONG:		return object(CallHelper<unsigned long>(dcCallLong, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_LONG_LONG:	return object(CallHelper<long long>(dcCallLongLong, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_ULONG_LONG:	return object(CallHelper<unsigned long long>(dcCallLongLong, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_FLOAT:		return object(CallHelper<float>(dcCallFloat, pVM, ulAddr, m_bThreadSafe));
+		case DATA_TYPE_DOUBLE:		return object(CallHelper<double>(dcCallDouble, pVM, ulAddr, m_bThreadSafe));
 		case DATA_TYPE_POINTER:
 		{
-			CPointer pPtr = CPointer(CallHelper<unsigned long>(dcCallPointer, g_pCallVM, m_ulAddr));
+			CPointer pPtr = CPointer(CallHelper<unsigned long>(dcCallPointer, pVM, ulAddr, m_bThreadSafe));
 			if (!m_oConverter.is_none())
 				return m_oConverter(pPtr);
 
 			return object(pPtr);
 		}
-		case DATA_TYPE_STRING:		return object(CallHelper<const char *>(dcCallPointer, g_pCallVM, m_ulAddr));
+		case DATA_TYPE_STRING:		return object(CallHelper<const char *>(dcCallPointer, pVM, ulAddr, m_bThreadSafe));
 		default:					BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown return type.")
 	}
 	return object();
 }
 
-object CFunction::CallTrampoline(tuple args, dict kw)
-{
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
-	if (!pHook)
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function was not hooked.")
-
-	return CFunction((unsigned long) pHook->m_pTrampoline, m_eCallingConvention,
-		m_iCallingConvention, m_tArgs, m_eReturnType, m_oConverter).Call(args, kw);
-}
-
-object CFunction::SkipHooks(tuple args, dict kw)
-{
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
-	if (pHook)
-		return CFunction((unsigned long) pHook->m_pTrampoline, m_eCallingConvention,
-			m_iCallingConvention, m_tArgs, m_eReturnType, m_oConverter).Call(args, kw);
-
-	return Call(args, kw);
-}
-
 CHook* HookFunctionHelper(void* addr, ICallingConvention* pConv)
 {
 	CHook* result;
 	TRY_SEGV()
-		result = GetHookManager()->HookFunction(addr, pConv);
+		result = HookFunction(addr, pConv);
 	EXCEPT_SEGV()
 	return result;
 }
 
-void CFunction::AddHook(HookType_t eType, PyObject* pCallable)
+void CFunction::AddHook(HookType_t eType, PyObject* pCallable, int iPriority /* = 0 */, bool bStopOnOverride /* = false */)
 {
 	if (!IsHookable())
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function is not hookable.")
 		
 	Validate();
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
+
+	if (eType == HOOKTYPE_POST_DEFERRED)
+	{
+		if (bStopOnOverride)
+			BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Deferred post-hooks can't override the return value.")
+
+		// Deferred post-hooks copy the arguments to a record of a fixed size
+		if (GetHookConvention()->m_vecArgTypes.size() > DEFERRED_HOOK_MAX_ARGS)
+			BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Deferred post-hooks support at most %i arguments.", DEFERRED_HOOK_MAX_ARGS)
+	}
 	
 	// Prepare arguments for log message
 	str type = str(eType);
@@ -380,45 +532,115 @@ void CFunction::AddHook(HookType_t eType, PyObject* pCallable)
 
 	PythonLog(
 		4,
-		"Hooking function: type=%s, addr=%u, conv=%s, args=%s, rtype=%s, callback=%s",
+		"Hooking function: type=%s, addr=%u, conv=%s, args=%s, rtype=%s, callback=%s, priority=%i",
 		szType,
 		m_ulAddr,
 		szConvention,
 		szArgs,
 		szReturnType,
-		szCallback
+		szCallback,
+		iPriority
 	);
 
+	CHook* pHook = InstallHook();
+	GetHookCallbacks(pHook, true)->AddCallback(eType, object(handle<>(borrowed(pCallable))), iPriority, bStopOnOverride);
+	UpdateHookHandler(pHook, eType);
+}
+
+ICallingConvention* CFunction::GetHookConvention()
+{
+	CHook* pHook = FindHook((void *) m_ulAddr);
+	return pHook ? pHook->m_pCallingConvention : m_pCallingConvention;
+}
+
+CHook* CFunction::InstallHook()
+{
+	CHook* pHook = FindHook((void *) m_ulAddr);
 	if (!pHook) {
 		pHook = HookFunctionHelper((void *) m_ulAddr, m_pCallingConvention);
 
 		// DynamicHooks will handle our convention from there, regardless if we allocated it or not.
 		m_bAllocatedCallingConvention = false;
 	}
-	
-	// Add the hook handler. If it's already added, it won't be added twice
-	pHook->AddCallback(eType, (HookHandlerFn *) (void *) &SP_HookHandler);
-	g_mapCallbacks[pHook][eType].push_back(object(handle<>(borrowed(pCallable))));
+
+	return pHook;
 }
 
 void CFunction::RemoveHook(HookType_t eType, PyObject* pCallable)
 {
 	Validate();
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
+	CHook* pHook = FindHook((void *) m_ulAddr);
 	if (!pHook)
 		return;
 
-	g_mapCallbacks[pHook][eType].remove(object(handle<>(borrowed(pCallable))));
+	CHookCallbacks* pCallbacks = GetHookCallbacks(pHook);
+	if (!pCallbacks)
+		return;
+
+	pCallbacks->RemoveCallback(eType, object(handle<>(borrowed(pCallable))));
+	UpdateHookHandler(pHook, eType);
+}
+
+void CFunction::AddNativeHook(HookType_t eType, const CNativeAction& action, object oCondition)
+{
+	if (!IsHookable())
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function is not hookable.")
+
+	if (eType == HOOKTYPE_POST_DEFERRED)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Native hooks can't be deferred.")
+
+	Validate();
+
+	// Resolve the operands before hooking the function, so invalid hooks
+	// don't leave a hook behind. They are accessed through the convention of
+	// the hook, which might differ from ours.
+	CNativeHook hook(action, oCondition);
+	hook.Resolve(GetHookConvention(), eType);
+
+	PythonLog(4, "Adding native hook: type=%i, addr=%u, action=%i", eType, m_ulAddr, action.m_eAction);
+
+	CHook* pHook = InstallHook();
+	GetHookCallbacks(pHook, true)->AddNativeHook(eType, hook);
+	UpdateHookHandler(pHook, eType);
+}
+
+void CFunction::RemoveNativeHook(HookType_t eType, const CNativeAction& action, object oCondition)
+{
+	if (eType == HOOKTYPE_POST_DEFERRED)
+		return;
+
+	Validate();
+	CHook* pHook = FindHook((void *) m_ulAddr);
+	if (!pHook)
+		return;
+
+	CHookCallbacks* pCallbacks = GetHookCallbacks(pHook);
+	if (!pCallbacks)
+		return;
+
+	CNativeHook hook(action, oCondition);
+	hook.Resolve(pHook->m_pCallingConvention, eType);
+	pCallbacks->RemoveNativeHook(eType, hook);
+	UpdateHookHandler(pHook, eType);
+}
+
+dict CFunction::GetHookStats()
+{
+	CHook* pHook = FindHook((void *) m_ulAddr);
+	if (!pHook)
+		return dict();
+
+	return ::GetHookStats(pHook);
 }
 
 void CFunction::DeleteHook()
 {
-	CHook* pHook = GetHookManager()->FindHook((void *) m_ulAddr);
+	CHook* pHook = FindHook((void *) m_ulAddr);
 	if (!pHook)
 		return;
 
-	g_mapCallbacks.erase(pHook);
+	DeleteHookCallbacks(pHook);
 	// Set the calling convention to NULL, because DynamicHooks will delete it otherwise.
 	pHook->m_pCallingConvention = NULL;
-	GetHookManager()->UnhookFunction((void *) m_ulAddr);
+	UnhookFunction((void *) m_ulAddr);
 }
\ No newline at end of file
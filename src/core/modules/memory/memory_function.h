@@ -30,12 +30,19 @@
 // ============================================================================
 // >> INCLUDES
 // ============================================================================
+// C++
+#include <vector>
+
 // Memory
 #include "memory_pointer.h"
+#include "memory_hooks.h"
 
 // DynamicHooks
 #include "manager.h"
 
+// DynCall
+#include "dyncall.h"
+
 
 // ============================================================================
 // >> Convention_t
@@ -50,6 +57,13 @@ enum Convention_t
 };
 
 
+// ============================================================================
+// >> ArgPusherFn
+// ============================================================================
+// Converts a Python object to a native argument and pushes it onto the VM.
+typedef void (*ArgPusherFn)(DCCallVM* vm, PyObject* pArg);
+
+
 // ============================================================================
 // >> CFunction
 // ============================================================================
@@ -62,6 +76,9 @@ public:
 
 	~CFunction();
 
+	// Trampolines and bound functions are created very often
+	DECLARE_FREELIST_ALLOCATOR(CFunction)
+
 	bool IsCallable();
 	bool IsHookable();
 
@@ -73,14 +90,20 @@ public:
 	object CallTrampoline(boost::python::tuple args, dict kw);
 	object SkipHooks(boost::python::tuple args, dict kw);
 
-	void AddHook(HookType_t eType, PyObject* pCallable);
+	object Call(PyObject** ppArgs, int iNumArgs);
+	object CallTrampoline(PyObject** ppArgs, int iNumArgs);
+	object SkipHooks(PyObject** ppArgs, int iNumArgs);
+
+	list CallMany(object oArguments);
+
+	void AddHook(HookType_t eType, PyObject* pCallable, int iPriority = 0, bool bStopOnOverride = false);
 	void RemoveHook(HookType_t eType, PyObject* pCallable);
 
-	void AddPreHook(PyObject* pCallable)
-	{ return AddHook(HOOKTYPE_PRE, pCallable); }
+	void AddPreHook(PyObject* pCallable, int iPriority = 0, bool bStopOnOverride = false)
+	{ return AddHook(HOOKTYPE_PRE, pCallable, iPriority, bStopOnOverride); }
 
-	void AddPostHook(PyObject* pCallable)
-	{ return AddHook(HOOKTYPE_POST, pCallable); }
+	void AddPostHook(PyObject* pCallable, int iPriority = 0, bool bStopOnOverride = false)
+	{ return AddHook(HOOKTYPE_POST, pCallable, iPriority, bStopOnOverride); }
 
 	void RemovePreHook(PyObject* pCallable)
 	{ RemoveHook(HOOKTYPE_PRE, pCallable); }
@@ -88,10 +111,35 @@ public:
 	void RemovePostHook(PyObject* pCallable)
 	{ RemoveHook(HOOKTYPE_POST, pCallable);	}
 
+	void AddDeferredPostHook(PyObject* pCallable, int iPriority = 0)
+	{ return AddHook(HOOKTYPE_POST_DEFERRED, pCallable, iPriority); }
+
+	void RemoveDeferredPostHook(PyObject* pCallable)
+	{ RemoveHook(HOOKTYPE_POST_DEFERRED, pCallable); }
+
+	void AddNativeHook(HookType_t eType, const CNativeAction& action, object oCondition);
+	void RemoveNativeHook(HookType_t eType, const CNativeAction& action, object oCondition);
+
+	dict GetHookStats();
+
 	void DeleteHook();
 
+protected:
+	void CompileSignature();
+	CHook* InstallHook();
+
+	// Returns the calling convention of the existing hook or our own. An
+	// existing hook might have been created with a different signature.
+	ICallingConvention* GetHookConvention();
+	object CallAddress(unsigned long ulAddr, PyObject** ppArgs, int iNumArgs);
+
 public:
 	boost::python::tuple	m_tArgs;
+
+	// Native copy of m_tArgs and the matching pushers, compiled once
+	std::vector<DataType_t>		m_vecArgTypes;
+	std::vector<ArgPusherFn>	m_vecArgPushers;
+
 	object					m_oConverter;
 	DataType_t				m_eReturnType;
 
@@ -104,6 +152,9 @@ public:
 	// DynamicHooks calling convention (built-in and custom)
 	ICallingConvention*		m_pCallingConvention;
 	bool					m_bAllocatedCallingConvention;
+
+	// If true, the GIL is released while the native function is running
+	bool					m_bThreadSafe;
 };
 
 
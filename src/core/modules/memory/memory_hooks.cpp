@@ -28,11 +28,21 @@
 // >> INCLUDES
 // ============================================================================
 #include "memory_hooks.h"
+#include "memory_deferred_hooks.h"
 #include "memory_utilities.h"
 #include "memory_pointer.h"
 #include "utilities/wrap_macros.h"
 #include "utilities/sp_util.h"
 
+#include <algorithm>
+#include <float.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
 #include "boost/python.hpp"
 using namespace boost::python;
 
@@ -40,15 +50,40 @@ using namespace boost::python;
 // ============================================================================
 // >> GLOBAL VARIABLES
 // ============================================================================
-// g_mapCallbacks[<CHook *>][<HookType_t>] -> [<object>, <object>, ...]
-std::map<CHook *, std::map<HookType_t, std::list<object> > > g_mapCallbacks;
+// g_mapCallbacks[<CHook *>] -> <CHookCallbacks *>
+typedef boost::unordered_map<CHook *, CHookCallbacks *> HookCallbacksMap;
+HookCallbacksMap g_mapCallbacks;
+
+// g_mapHooks[<function address>] -> <CHook *>
+typedef boost::unordered_map<void *, CHook *> HookIndexMap;
+HookIndexMap g_mapHooks;
 
 bool g_HooksDisabled;
+long g_lHookThreadId = 0;
+bool g_HookProfiling = false;
+PyObject* g_pHookStop = NULL;
 
 
 // ============================================================================
 // >> HELPER FUNCTIONS
 // ============================================================================
+double GetProfilerTime()
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency = {0};
+	if (!frequency.QuadPart)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (double) counter.QuadPart / frequency.QuadPart;
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+#endif
+}
+
 template<class T>
 void SetReturnValue(CHook* pHook, object value)
 {
@@ -75,20 +110,137 @@ object GetArgument(CHook* pHook, int iIndex)
 	return object(pHook->GetArgument<T>(iIndex));
 }
 
+object GetPointerArgument(CHook* pHook, int iIndex)
+{
+	return object(CPointer(pHook->GetArgument<unsigned long>(iIndex)));
+}
+
+void SetPointerArgument(CHook* pHook, int iIndex, object value)
+{
+	CPointer* pPtr = ExtractPointer(value);
+	pHook->SetArgument<unsigned long>(iIndex, pPtr->m_ulAddr);
+}
+
+object GetUnknownArgument(CHook* pHook, int iIndex)
+{
+	BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown type.")
+	return object();
+}
+
+void SetUnknownArgument(CHook* pHook, int iIndex, object value)
+{
+	BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown type.")
+}
+
+ArgConverter_t GetArgConverter(DataType_t type)
+{
+	ArgConverter_t converter;
+	switch(type)
+	{
+		case DATA_TYPE_BOOL:		converter.m_pGet = &GetArgument<bool>; converter.m_pSet = &SetArgument<bool>; break;
+		case DATA_TYPE_CHAR:		converter.m_pGet = &GetArgument<char>; converter.m_pSet = &SetArgument<char>; break;
+		case DATA_TYPE_UCHAR:		converter.m_pGet = &GetArgument<unsigned char>; converter.m_pSet = &SetArgument<unsigned char>; break;
+		case DATA_TYPE_SHORT:		converter.m_pGet = &GetArgument<short>; converter.m_pSet = &SetArgument<short>; break;
+		case DATA_TYPE_USHORT:		converter.m_pGet = &GetArgument<unsigned short>; converter.m_pSet = &SetArgument<unsigned short>; break;
+		case DATA_TYPE_INT:			converter.m_pGet = &GetArgument<int>; converter.m_pSet = &SetArgument<int>; break;
+		case DATA_TYPE_UINT:		converter.m_pGet = &GetArgument<unsigned int>; converter.m_pSet = &SetArgument<unsigned int>; break;
+		case DATA_TYPE_LONG:		converter.m_pGet = &GetArgument<long>; converter.m_pSet = &SetArgument<long>; break;
+		case DATA_TYPE_ULONG:		converter.m_pGet = &GetArgument<unsigned long>; converter.m_pSet = &SetArgument<unsigned long>; break;
+		case DATA_TYPE_LONG_LONG:	converter.m_pGet = &GetArgument<long long>; converter.m_pSet = &SetArgument<long long>; break;
+		case DATA_TYPE_ULONG_LONG:	converter.m_pGet = &GetArgument<unsigned long long>; converter.m_pSet = &SetArgument<unsigned long long>; break;
+		case DATA_TYPE_FLOAT:		converter.m_pGet = &GetArgument<float>; converter.m_pSet = &SetArgument<float>; break;
+		case DATA_TYPE_DOUBLE:		converter.m_pGet = &GetArgument<double>; converter.m_pSet = &SetArgument<double>; break;
+		case DATA_TYPE_POINTER:		converter.m_pGet = &GetPointerArgument; converter.m_pSet = &SetPointerArgument; break;
+		case DATA_TYPE_STRING:		converter.m_pGet = &GetArgument<const char *>; converter.m_pSet = &SetArgument<const char *>; break;
+		default:					converter.m_pGet = &GetUnknownArgument; converter.m_pSet = &SetUnknownArgument; break;
+	}
+	return converter;
+}
+
 
 // ============================================================================
 // >> SP_HookHandler
 // ============================================================================
+// Makes sure the GIL is held for the lifetime of the object. It might have
+// been released to call a thread-safe function.
+class CEnsureGIL
+{
+public:
+	CEnsureGIL(bool bEnsure)
+	{
+		m_bEnsured = bEnsure;
+		if (m_bEnsured)
+			m_State = PyGILState_Ensure();
+	}
+
+	~CEnsureGIL()
+	{
+		if (m_bEnsured)
+			PyGILState_Release(m_State);
+	}
+
+private:
+	bool				m_bEnsured;
+	PyGILState_STATE	m_State;
+};
+
+// Deferred post-hooks receive the final arguments and return value
+inline void CaptureDeferredCall(HookType_t eHookType, CHookCallbacks* pCallbacks, CHook* pHook)
+{
+	if (eHookType == HOOKTYPE_POST && pCallbacks->HasCallbacks(HOOKTYPE_POST_DEFERRED))
+		GetDeferredHookBuffer()->Capture(pHook);
+}
+
 bool SP_HookHandler(HookType_t eHookType, CHook* pHook)
 {
 	if (g_HooksDisabled)
 		return false;
 
-	std::list<object> callbacks = g_mapCallbacks[pHook][eHookType];
+	CHookCallbacks* pCallbacks = GetHookCallbacks(pHook);
+	if (!pCallbacks)
+		return false;
+
+	// Only take the time if profiling is enabled
+	double dStartTime = g_HookProfiling ? GetProfilerTime() : 0;
+
+	// Native hooks are always executed before the Python callbacks
+	bool bOverride = false;
+	NativeHookSnapshot nativeHooks = pCallbacks->GetNativeHooks(eHookType);
+	if (nativeHooks)
+	{
+		for (NativeHookVector::const_iterator it=nativeHooks->begin(); it != nativeHooks->end(); ++it)
+		{
+			if (it->Run(pHook))
+				bOverride = true;
+		}
+	}
+
+	// Only acquire the GIL if there is something to do in Python
+	if (!(pCallbacks->HasPythonHandlers(eHookType) || g_HookProfiling))
+		return bOverride;
+
+	// Must be destroyed last, because the objects below might release Python
+	// references. Other threads are not handled differently than before,
+	// because waiting for the GIL there could deadlock the main thread.
+	CEnsureGIL gil(IsHookThread());
+
+	HookStatsPtr pStats;
+	if (g_HookProfiling)
+		pStats = pCallbacks->GetStats();
+
+	// Keep our own reference to the current callbacks, so they can be added or
+	// removed by the callbacks themselves
+	CallbackSnapshot callbacks = pCallbacks->GetCallbacks(eHookType);
 
 	// No need to do all this stuff, if there is no callback registered
-	if (callbacks.empty())
-		return false;
+	if (!callbacks)
+	{
+		CaptureDeferredCall(eHookType, pCallbacks, pHook);
+		if (pStats)
+			pStats->GetDispatchStats(eHookType).Record(GetProfilerTime() - dStartTime, bOverride);
+
+		return bOverride;
+	}
 
 	object retval;
 	if (eHookType == HOOKTYPE_POST)
@@ -115,20 +267,33 @@ bool SP_HookHandler(HookType_t eHookType, CHook* pHook)
 		}
 	}
 	
-	CStackData stackdata = CStackData(pHook);
-	bool bOverride = false;
-	for (std::list<object>::iterator it=callbacks.begin(); it != callbacks.end(); ++it)
+	// All callbacks share the same StackData object and its cache
+	object stackdata = object(CStackData(pHook));
+	bool bStop = false;
+	for (CallbackVector::const_iterator it=callbacks->begin(); it != callbacks->end() && !bStop; ++it)
 	{
 		BEGIN_BOOST_PY()
+			double dCallbackStartTime = pStats ? GetProfilerTime() : 0;
+
 			object pyretval;
 			if (eHookType == HOOKTYPE_PRE)
-				pyretval = (*it)(stackdata);
+				pyretval = it->m_oCallback(stackdata);
 			else
-				pyretval = (*it)(stackdata, retval);
+				pyretval = it->m_oCallback(stackdata, retval);
+
+			bStop = pyretval.ptr() == g_pHookStop;
+			bool bCallbackOverride = !bStop && !pyretval.is_none();
+			if (pStats && IsCallbackRegistered(pHook, eHookType, callbacks, it->m_oCallback.ptr()))
+			{
+				pStats->GetCallbackStats(eHookType, it->m_oCallback.ptr()).Record(
+					GetProfilerTime() - dCallbackStartTime, bCallbackOverride);
+			}
 
-			if (!pyretval.is_none())
+			if (bCallbackOverride)
 			{
 				bOverride = true;
+				bStop = it->m_bStopOnOverride;
+
 				switch(pHook->m_pCallingConvention->m_returnType)
 				{
 					case DATA_TYPE_VOID:		break;
@@ -156,79 +321,355 @@ bool SP_HookHandler(HookType_t eHookType, CHook* pHook)
 			}
 		END_BOOST_PY_NORET()
 	}
+
+	CaptureDeferredCall(eHookType, pCallbacks, pHook);
+	if (pStats)
+		pStats->GetDispatchStats(eHookType).Record(GetProfilerTime() - dStartTime, bOverride);
+
 	return bOverride;
 }
 
 
+// ============================================================================
+// >> CHookCallbacks
+// ============================================================================
+struct HasLowerPriority
+{
+	bool operator()(int iPriority, const HookCallback_t& callback) const
+	{ return callback.m_iPriority < iPriority; }
+};
+
+struct IsCallback
+{
+	IsCallback(object oCallback): m_oCallback(oCallback) {}
+
+	bool operator()(const HookCallback_t& callback) const
+	{ return callback.m_oCallback == m_oCallback; }
+
+	object m_oCallback;
+};
+
+void CHookCallbacks::AddCallback(HookType_t eHookType, object oCallback, int iPriority /* = 0 */, bool bStopOnOverride /* = false */)
+{
+	CallbackVector* pNew = m_pCallbacks[eHookType] ? new CallbackVector(*m_pCallbacks[eHookType]) : new CallbackVector();
+
+	HookCallback_t callback;
+	callback.m_oCallback = oCallback;
+	callback.m_iPriority = iPriority;
+	callback.m_bStopOnOverride = bStopOnOverride;
+
+	// Insert it behind all callbacks with the same or a higher priority
+	pNew->insert(std::upper_bound(pNew->begin(), pNew->end(), iPriority, HasLowerPriority()), callback);
+	m_pCallbacks[eHookType] = CallbackSnapshot(pNew);
+}
+
+void CHookCallbacks::RemoveCallback(HookType_t eHookType, object oCallback)
+{
+	if (!m_pCallbacks[eHookType])
+		return;
+
+	CallbackVector* pNew = new CallbackVector(*m_pCallbacks[eHookType]);
+	pNew->erase(std::remove_if(pNew->begin(), pNew->end(), IsCallback(oCallback)), pNew->end());
+
+	if (m_pStats)
+		m_pStats->Prune(eHookType, pNew);
+
+	if (pNew->empty())
+	{
+		delete pNew;
+		m_pCallbacks[eHookType].reset();
+	}
+	else
+	{
+		m_pCallbacks[eHookType] = CallbackSnapshot(pNew);
+	}
+}
+
+void CHookCallbacks::AddNativeHook(HookType_t eHookType, const CNativeHook& hook)
+{
+	NativeHookVector* pNew = m_pNativeHooks[eHookType] ? new NativeHookVector(*m_pNativeHooks[eHookType]) : new NativeHookVector();
+	pNew->push_back(hook);
+	m_pNativeHooks[eHookType] = NativeHookSnapshot(pNew);
+}
+
+void CHookCallbacks::RemoveNativeHook(HookType_t eHookType, const CNativeHook& hook)
+{
+	if (!m_pNativeHooks[eHookType])
+		return;
+
+	NativeHookVector* pNew = new NativeHookVector(*m_pNativeHooks[eHookType]);
+	pNew->erase(std::remove(pNew->begin(), pNew->end(), hook), pNew->end());
+	if (pNew->empty())
+	{
+		delete pNew;
+		m_pNativeHooks[eHookType].reset();
+	}
+	else
+	{
+		m_pNativeHooks[eHookType] = NativeHookSnapshot(pNew);
+	}
+}
+
+ArgConverterTable CHookCallbacks::GetArgConverters(CHook* pHook)
+{
+	if (!m_pArgConverters)
+		m_pArgConverters = CreateArgConverters(pHook->m_pCallingConvention);
+
+	return m_pArgConverters;
+}
+
+ArgConverterTable CreateArgConverters(ICallingConvention* pConvention)
+{
+	ArgConverterVector* pConverters = new ArgConverterVector();
+	pConverters->reserve(pConvention->m_vecArgTypes.size());
+
+	for (std::vector<DataType_t>::iterator it=pConvention->m_vecArgTypes.begin(); it != pConvention->m_vecArgTypes.end(); ++it)
+		pConverters->push_back(GetArgConverter(*it));
+
+	return ArgConverterTable(pConverters);
+}
+
+CHookCallbacks* GetHookCallbacks(CHook* pHook, bool bCreate /* = false */)
+{
+	HookCallbacksMap::iterator it = g_mapCallbacks.find(pHook);
+	if (it != g_mapCallbacks.end())
+		return it->second;
+
+	if (!bCreate)
+		return NULL;
+
+	CHookCallbacks* pCallbacks = new CHookCallbacks();
+	g_mapCallbacks[pHook] = pCallbacks;
+	return pCallbacks;
+}
+
+void UpdateHookHandler(CHook* pHook, HookType_t eHookType)
+{
+	if (eHookType == HOOKTYPE_POST_DEFERRED)
+		eHookType = HOOKTYPE_POST;
+
+	HookHandlerFn* pHandler = (HookHandlerFn *) (void *) &SP_HookHandler;
+	CHookCallbacks* pCallbacks = GetHookCallbacks(pHook);
+
+	// CHook::HookHandler iterates over a copy of its handlers, so this is
+	// also safe while the hook is being dispatched
+	if (pCallbacks && pCallbacks->HasHandlers(eHookType))
+		pHook->AddCallback(eHookType, pHandler);
+	else if (pHook->IsCallbackRegistered(eHookType, pHandler))
+		pHook->RemoveCallback(eHookType, pHandler);
+}
+
+void DeleteHookCallbacks(CHook* pHook)
+{
+	HookCallbacksMap::iterator it = g_mapCallbacks.find(pHook);
+	if (it == g_mapCallbacks.end())
+		return;
+
+	GetDeferredHookBuffer()->Discard(pHook);
+
+	// Running dispatches hold their own snapshot, so this is safe
+	delete it->second;
+	g_mapCallbacks.erase(it);
+}
+
+
+// ============================================================================
+// >> Hook profiling
+// ============================================================================
+void HookStats_t::Reset()
+{
+	m_ulCalls = 0;
+	m_ulOverrides = 0;
+	m_dTotalTime = 0;
+	m_dMinTime = DBL_MAX;
+	m_dMaxTime = 0;
+}
+
+void HookStats_t::Record(double dTime, bool bOverride)
+{
+	m_ulCalls++;
+	if (bOverride)
+		m_ulOverrides++;
+
+	m_dTotalTime += dTime;
+	if (dTime < m_dMinTime)
+		m_dMinTime = dTime;
+
+	if (dTime > m_dMaxTime)
+		m_dMaxTime = dTime;
+}
+
+void CHookStats::Prune(HookType_t eHookType, const CallbackVector* pCallbacks)
+{
+	CallbackStatsMap& stats = m_Callbacks[eHookType];
+	for (CallbackStatsMap::iterator it=stats.begin(); it != stats.end();)
+	{
+		bool bFound = false;
+		for (CallbackVector::const_iterator callback=pCallbacks->begin(); callback != pCallbacks->end(); ++callback)
+		{
+			if (callback->m_oCallback.ptr() == it->first)
+			{
+				bFound = true;
+				break;
+			}
+		}
+
+		if (bFound)
+			++it;
+		else
+			it = stats.erase(it);
+	}
+}
+
+bool IsCallbackRegistered(CHook* pHook, HookType_t eHookType, const CallbackSnapshot& dispatched, PyObject* pCallback)
+{
+	// The callbacks might have been deleted by the callback
+	CHookCallbacks* pCallbacks = GetHookCallbacks(pHook);
+	if (!pCallbacks)
+		return false;
+
+	CallbackSnapshot current = pCallbacks->GetCallbacks(eHookType);
+	if (current == dispatched)
+		return true;
+
+	if (!current)
+		return false;
+
+	for (CallbackVector::const_iterator it=current->begin(); it != current->end(); ++it)
+	{
+		if (it->m_oCallback.ptr() == pCallback)
+			return true;
+	}
+
+	return false;
+}
+
+void CHookStats::Reset()
+{
+	for (int i=0; i < HOOKTYPE_COUNT; i++)
+	{
+		m_Dispatch[i].Reset();
+		m_Callbacks[i].clear();
+	}
+}
+
+void CHookStats::ToDict(CHook* pHook, dict result)
+{
+	unsigned long ulAddr = (unsigned long) pHook->m_pFunc;
+	for (int i=0; i < HOOKTYPE_COUNT; i++)
+	{
+		HookType_t eHookType = (HookType_t) i;
+		if (!m_Dispatch[i].m_ulCalls)
+			continue;
+
+		result[make_tuple(ulAddr, eHookType, object())] = m_Dispatch[i];
+		for (CallbackStatsMap::iterator it=m_Callbacks[i].begin(); it != m_Callbacks[i].end(); ++it)
+			result[make_tuple(ulAddr, eHookType, object(handle<>(borrowed(it->first))))] = it->second;
+	}
+}
+
+dict GetHookStats(CHook* pHook /* = NULL */)
+{
+	dict result;
+	for (HookCallbacksMap::iterator it=g_mapCallbacks.begin(); it != g_mapCallbacks.end(); ++it)
+	{
+		if (pHook && it->first != pHook)
+			continue;
+
+		HookStatsPtr pStats = it->second->GetStatsIfExists();
+		if (pStats)
+			pStats->ToDict(it->first, result);
+	}
+
+	return result;
+}
+
+void ResetHookStats()
+{
+	for (HookCallbacksMap::iterator it=g_mapCallbacks.begin(); it != g_mapCallbacks.end(); ++it)
+	{
+		HookStatsPtr pStats = it->second->GetStatsIfExists();
+		if (pStats)
+			pStats->Reset();
+	}
+}
+
+
+// ============================================================================
+// >> Hook index
+// ============================================================================
+CHook* FindHook(void* pFunc)
+{
+	HookIndexMap::iterator it = g_mapHooks.find(pFunc);
+	if (it == g_mapHooks.end())
+		return NULL;
+
+	return it->second;
+}
+
+CHook* HookFunction(void* pFunc, ICallingConvention* pConvention)
+{
+	CHook* pHook = GetHookManager()->HookFunction(pFunc, pConvention);
+	if (pHook)
+		g_mapHooks[pFunc] = pHook;
+
+	return pHook;
+}
+
+void UnhookFunction(void* pFunc)
+{
+	g_mapHooks.erase(pFunc);
+	GetHookManager()->UnhookFunction(pFunc);
+}
+
+void UnhookAllFunctions()
+{
+	GetDeferredHookBuffer()->Discard();
+	g_mapHooks.clear();
+	GetHookManager()->UnhookAllFunctions();
+}
+
+
 // ============================================================================
 // >> CStackData
 // ============================================================================
 CStackData::CStackData(CHook* pHook)
 {
 	m_pHook = pHook;
+
+	CHookCallbacks* pCallbacks = GetHookCallbacks(pHook);
+	if (pCallbacks)
+		m_pConverters = pCallbacks->GetArgConverters(pHook);
+	else
+		m_pConverters = CreateArgConverters(pHook->m_pCallingConvention);
 }
 
 object CStackData::GetItem(unsigned int iIndex)
 {
-	if (iIndex >= (unsigned int) m_pHook->m_pCallingConvention->m_vecArgTypes.size())
+	if (iIndex >= (unsigned int) m_pConverters->size())
 		BOOST_RAISE_EXCEPTION(PyExc_IndexError, "Index out of range.")
 
 	// Argument already cached?
-	object retval = m_mapCache[iIndex];
-	if (retval)
-		return retval;
-
-	switch(m_pHook->m_pCallingConvention->m_vecArgTypes[iIndex])
-	{
-		case DATA_TYPE_BOOL:		retval = GetArgument<bool>(m_pHook, iIndex); break;
-		case DATA_TYPE_CHAR:		retval = GetArgument<char>(m_pHook, iIndex); break;
-		case DATA_TYPE_UCHAR:		retval = GetArgument<unsigned char>(m_pHook, iIndex); break;
-		case DATA_TYPE_SHORT:		retval = GetArgument<short>(m_pHook, iIndex); break;
-		case DATA_TYPE_USHORT:		retval = GetArgument<unsigned short>(m_pHook, iIndex); break;
-		case DATA_TYPE_INT:			retval = GetArgument<int>(m_pHook, iIndex); break;
-		case DATA_TYPE_UINT:		retval = GetArgument<unsigned int>(m_pHook, iIndex); break;
-		case DATA_TYPE_LONG:		retval = GetArgument<long>(m_pHook, iIndex); break;
-		case DATA_TYPE_ULONG:		retval = GetArgument<unsigned long>(m_pHook, iIndex); break;
-		case DATA_TYPE_LONG_LONG:	retval = GetArgument<long long>(m_pHook, iIndex); break;
-		case DATA_TYPE_ULONG_LONG:	retval = GetArgument<unsigned long long>(m_pHook, iIndex); break;
-		case DATA_TYPE_FLOAT:		retval = GetArgument<float>(m_pHook, iIndex); break;
-		case DATA_TYPE_DOUBLE:		retval = GetArgument<double>(m_pHook, iIndex); break;
-		case DATA_TYPE_POINTER:		retval = object(CPointer(m_pHook->GetArgument<unsigned long>(iIndex))); break;
-		case DATA_TYPE_STRING:		retval = GetArgument<const char *>(m_pHook, iIndex); break;
-		default: BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown type.") break;
-	}
-	m_mapCache[iIndex] = retval;
+	bool bCacheable = iIndex < STACK_DATA_CACHE_SIZE;
+	if (bCacheable && !m_Cache[iIndex].is_none())
+		return m_Cache[iIndex];
+
+	object retval = (*m_pConverters)[iIndex].m_pGet(m_pHook, iIndex);
+	if (bCacheable)
+		m_Cache[iIndex] = retval;
+
 	return retval;
 }
 
 void CStackData::SetItem(unsigned int iIndex, object value)
 {
-	if (iIndex >= (unsigned int) m_pHook->m_pCallingConvention->m_vecArgTypes.size())
+	if (iIndex >= (unsigned int) m_pConverters->size())
 		BOOST_RAISE_EXCEPTION(PyExc_IndexError, "Index out of range.")
 
-	// Update cache
-	m_mapCache[iIndex] = value;
-	switch(m_pHook->m_pCallingConvention->m_vecArgTypes[iIndex])
-	{
-		case DATA_TYPE_BOOL:		SetArgument<bool>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_CHAR:		SetArgument<char>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_UCHAR:		SetArgument<unsigned char>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_SHORT:		SetArgument<short>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_USHORT:		SetArgument<unsigned short>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_INT:			SetArgument<int>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_UINT:		SetArgument<unsigned int>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_LONG:		SetArgument<long>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_ULONG:		SetArgument<unsigned long>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_LONG_LONG:	SetArgument<long long>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_ULONG_LONG:	SetArgument<unsigned long long>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_FLOAT:		SetArgument<float>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_DOUBLE:		SetArgument<double>(m_pHook, iIndex, value); break;
-		case DATA_TYPE_POINTER:
-		{
-			CPointer* pPtr = ExtractPointer(value);
-			SetArgument<unsigned long>(m_pHook, iIndex, object(pPtr->m_ulAddr));
-		} break;
-		case DATA_TYPE_STRING:		SetArgument<const char *>(m_pHook, iIndex, value); break;
-		default: BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Unknown type.")
-	}
+	(*m_pConverters)[iIndex].m_pSet(m_pHook, iIndex, value);
+
+	// The next read converts the stored value again, so all callbacks see
+	// the same type and the truncated value
+	if (iIndex < STACK_DATA_CACHE_SIZE)
+		m_Cache[iIndex] = object();
 }
@@ -32,16 +32,185 @@
 //---------------------------------------------------------------------------------
 #include <list>
 #include <map>
+#include <vector>
 
 #include "boost/python.hpp"
 using namespace boost::python;
 
+#include "pythread.h"
+
+#include "boost/shared_ptr.hpp"
+#include "boost/unordered_map.hpp"
+
 // DynamicHooks
 #include "hook.h"
+#include "manager.h"
+
+// Memory
+#include "memory_native_hook.h"
+
+//---------------------------------------------------------------------------------
+// Typedefs
+//---------------------------------------------------------------------------------
+struct HookCallback_t
+{
+	object	m_oCallback;
+
+	// Callbacks with a higher priority are called first
+	int		m_iPriority;
+
+	// Skip the remaining callbacks if this callback overrides the return value
+	bool	m_bStopOnOverride;
+};
+
+// Sorted by priority. Callbacks with the same priority are kept in the order
+// they were added.
+typedef std::vector<HookCallback_t> CallbackVector;
+
+// Immutable snapshot of the callbacks of a hook type. It's replaced whenever a
+// callback is added or removed, so a running dispatch is never affected.
+typedef boost::shared_ptr<const CallbackVector> CallbackSnapshot;
+
+// Convert an argument of a hook from/to Python
+typedef object (*ArgGetterFn)(CHook* pHook, int iIndex);
+typedef void (*ArgSetterFn)(CHook* pHook, int iIndex, object value);
+
+struct ArgConverter_t
+{
+	ArgGetterFn m_pGet;
+	ArgSetterFn m_pSet;
+};
+
+// The converters for all arguments of a hook. They are resolved once per
+// hook and shared by all of its CStackData objects.
+typedef std::vector<ArgConverter_t> ArgConverterVector;
+typedef boost::shared_ptr<const ArgConverterVector> ArgConverterTable;
+
+// Type of CHook::m_RetAddr
+typedef std::map<void*, std::vector<void*> > ReturnAddressMap;
+
+// Maximum number of arguments that are cached by CStackData
+#define STACK_DATA_CACHE_SIZE 16
+
+// DynamicHooks only knows pre- and post-hooks. Deferred post-hooks are
+// captured by the post-hook handler and delivered at the end of the frame.
+#define HOOKTYPE_POST_DEFERRED ((HookType_t) (HOOKTYPE_POST + 1))
+#define HOOKTYPE_COUNT (HOOKTYPE_POST_DEFERRED + 1)
+
+
+//---------------------------------------------------------------------------------
+// Hook profiling
+//---------------------------------------------------------------------------------
+// Times are measured in seconds
+struct HookStats_t
+{
+	HookStats_t()
+	{ Reset(); }
+
+	void Reset();
+	void Record(double dTime, bool bOverride);
+
+	double GetAverageTime()
+	{ return m_ulCalls ? m_dTotalTime / m_ulCalls : 0; }
+
+	unsigned long	m_ulCalls;
+	unsigned long	m_ulOverrides;
+	double			m_dTotalTime;
+	double			m_dMinTime;
+	double			m_dMaxTime;
+};
+
+// m_Callbacks[<hook type>][<callback>] -> <stats>
+typedef boost::unordered_map<PyObject *, HookStats_t> CallbackStatsMap;
+
+class CHookStats
+{
+public:
+	// Stats of the whole dispatch, including native hooks
+	HookStats_t& GetDispatchStats(HookType_t eHookType)
+	{ return m_Dispatch[eHookType]; }
+
+	HookStats_t& GetCallbackStats(HookType_t eHookType, PyObject* pCallback)
+	{ return m_Callbacks[eHookType][pCallback]; }
+
+	// Removes the stats of callbacks that are no longer registered
+	void Prune(HookType_t eHookType, const CallbackVector* pCallbacks);
+
+	void Reset();
+
+	// Adds {(<address>, <hook type>, <callback or None>): <stats>} to the dict
+	void ToDict(CHook* pHook, dict result);
+
+private:
+	HookStats_t			m_Dispatch[HOOKTYPE_COUNT];
+	CallbackStatsMap	m_Callbacks[HOOKTYPE_COUNT];
+};
+
+typedef boost::shared_ptr<CHookStats> HookStatsPtr;
+
 
 //---------------------------------------------------------------------------------
 // Classes
 //---------------------------------------------------------------------------------
+class CHookCallbacks
+{
+public:
+	CallbackSnapshot GetCallbacks(HookType_t eHookType)
+	{ return m_pCallbacks[eHookType]; }
+
+	bool HasCallbacks(HookType_t eHookType)
+	{ return m_pCallbacks[eHookType].get() != NULL; }
+
+	// Returns true if the hook handler needs to call into Python. Deferred
+	// post-hooks count as post-hooks, because they are captured by them.
+	bool HasPythonHandlers(HookType_t eHookType)
+	{
+		if (eHookType == HOOKTYPE_POST && m_pCallbacks[HOOKTYPE_POST_DEFERRED])
+			return true;
+
+		return m_pCallbacks[eHookType].get() != NULL;
+	}
+
+	// Returns true if there are Python callbacks or native hooks
+	bool HasHandlers(HookType_t eHookType)
+	{ return HasPythonHandlers(eHookType) || m_pNativeHooks[eHookType]; }
+
+	void AddCallback(HookType_t eHookType, object oCallback, int iPriority = 0, bool bStopOnOverride = false);
+	void RemoveCallback(HookType_t eHookType, object oCallback);
+
+	NativeHookSnapshot GetNativeHooks(HookType_t eHookType)
+	{ return m_pNativeHooks[eHookType]; }
+
+	void AddNativeHook(HookType_t eHookType, const CNativeHook& hook);
+	void RemoveNativeHook(HookType_t eHookType, const CNativeHook& hook);
+
+	ArgConverterTable GetArgConverters(CHook* pHook);
+
+	// Dispatches keep their own reference, because the callbacks might be
+	// deleted by a callback
+	HookStatsPtr GetStats()
+	{
+		if (!m_pStats)
+			m_pStats = HookStatsPtr(new CHookStats());
+		return m_pStats;
+	}
+
+	HookStatsPtr GetStatsIfExists()
+	{ return m_pStats; }
+
+private:
+	// An empty snapshot is always stored as NULL
+	CallbackSnapshot m_pCallbacks[HOOKTYPE_COUNT];
+
+	// Native hooks can't be deferred
+	NativeHookSnapshot m_pNativeHooks[HOOKTYPE_POST + 1];
+
+	// Created on first use
+	ArgConverterTable m_pArgConverters;
+	HookStatsPtr m_pStats;
+};
+
+
 class CStackData
 {
 public:
@@ -59,15 +228,21 @@ public:
 	void* GetReturnAddress()
 	{
 		void* pESP = m_pHook->m_pRegisters->m_esp->GetValue<void*>();
-		if (m_pHook->m_RetAddr.count(pESP) == 0) {
+
+		// Single lookup that never inserts into the hook's map
+		ReturnAddressMap::const_iterator it = m_pHook->m_RetAddr.find(pESP);
+		if (it == m_pHook->m_RetAddr.end() || it->second.empty())
 			return NULL;
-		}
-		return m_pHook->m_RetAddr[pESP].back();
+
+		return it->second.back();
 	}
 
 protected:
-	CHook*                m_pHook;
-	std::map<int, object> m_mapCache;
+	CHook*				m_pHook;
+	ArgConverterTable	m_pConverters;
+
+	// None if the argument hasn't been converted yet
+	object				m_Cache[STACK_DATA_CACHE_SIZE];
 };
 
 
@@ -76,8 +251,72 @@ protected:
 //---------------------------------------------------------------------------------
 bool SP_HookHandler(HookType_t eHookType, CHook* pHook);
 
+ArgConverterTable CreateArgConverters(ICallingConvention* pConvention);
+
+CHookCallbacks* GetHookCallbacks(CHook* pHook, bool bCreate = false);
+
+// Registers SP_HookHandler for the given hook type if there are handlers and
+// removes it otherwise, so DynamicHooks doesn't call it for nothing.
+void UpdateHookHandler(CHook* pHook, HookType_t eHookType);
+void DeleteHookCallbacks(CHook* pHook);
+
+// Address-indexed wrappers around CHookManager. Always use these instead of
+// calling GetHookManager() directly, so the index stays in sync.
+CHook* FindHook(void* pFunc);
+CHook* HookFunction(void* pFunc, ICallingConvention* pConvention);
+void UnhookFunction(void* pFunc);
+void UnhookAllFunctions();
+
+// Returns {(<address>, <hook type>, <callback or None>): <HookStats>} of the
+// given hook or of all hooks if it's NULL
+dict GetHookStats(CHook* pHook);
+
+inline dict GetAllHookStats()
+{
+	return GetHookStats(NULL);
+}
+void ResetHookStats();
+
+// Callback stats are keyed by borrowed references. They must only be recorded
+// if the callback is still registered, because removing it prunes its stats
+// and might free it.
+bool IsCallbackRegistered(CHook* pHook, HookType_t eHookType, const CallbackSnapshot& dispatched, PyObject* pCallback);
+
+// Returns a monotonic time in seconds
+double GetProfilerTime();
+
 extern bool g_HooksDisabled;
 
+// Return this from a hook callback to skip the remaining callbacks. It's
+// intentionally leaked, because a global object would be released after the
+// interpreter has been finalized.
+extern PyObject* g_pHookStop;
+extern bool g_HookProfiling;
+
+inline void SetHookProfiling(bool value)
+{
+	g_HookProfiling = value;
+}
+
+inline bool GetHookProfiling()
+{
+	return g_HookProfiling;
+}
+
+// The hook handler makes sure it holds the GIL on this thread, because it
+// might have been released to call a thread-safe function.
+extern long g_lHookThreadId;
+
+inline void SetHookThread()
+{
+	g_lHookThreadId = PyThread_get_thread_ident();
+}
+
+inline bool IsHookThread()
+{
+	return PyThread_get_thread_ident() == g_lHookThreadId;
+}
+
 inline void SetHooksDisabled(bool value)
 {
 	g_HooksDisabled = value;
@@ -0,0 +1,392 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+// Memory
+#include "memory_native_hook.h"
+#include "memory_utilities.h"
+
+
+// ============================================================================
+// >> HELPERS
+// ============================================================================
+inline bool IsFloatType(DataType_t eType)
+{
+	return eType == DATA_TYPE_FLOAT || eType == DATA_TYPE_DOUBLE;
+}
+
+template<class T>
+inline bool Compare(NativeCompare_t eCompare, T value, T other)
+{
+	switch(eCompare)
+	{
+		case NATIVE_COMPARE_EQUAL:			return value == other;
+		case NATIVE_COMPARE_NOT_EQUAL:		return value != other;
+		case NATIVE_COMPARE_LESS:			return value < other;
+		case NATIVE_COMPARE_LESS_EQUAL:		return value <= other;
+		case NATIVE_COMPARE_GREATER:		return value > other;
+		case NATIVE_COMPARE_GREATER_EQUAL:	return value >= other;
+		default: break;
+	}
+	return false;
+}
+
+
+// ============================================================================
+// >> NativeValue_t
+// ============================================================================
+void NativeValue_t::FromPython(object oValue)
+{
+	extract<CPointer *> extractPtr(oValue);
+	if (extractPtr.check())
+	{
+		m_llInt = (long long) extractPtr()->m_ulAddr;
+		m_dFloat = (double) m_llInt;
+	}
+	else if (PyFloat_Check(oValue.ptr()))
+	{
+		m_dFloat = extract<double>(oValue);
+		m_llInt = (long long) m_dFloat;
+	}
+	else
+	{
+		m_llInt = extract<long long>(oValue);
+		m_dFloat = (double) m_llInt;
+	}
+}
+
+void NativeValue_t::Load(void* pAddr, DataType_t eType)
+{
+	switch(eType)
+	{
+		case DATA_TYPE_BOOL:		m_llInt = *(bool *) pAddr; break;
+		case DATA_TYPE_CHAR:		m_llInt = *(char *) pAddr; break;
+		case DATA_TYPE_UCHAR:		m_llInt = *(unsigned char *) pAddr; break;
+		case DATA_TYPE_SHORT:		m_llInt = *(short *) pAddr; break;
+		case DATA_TYPE_USHORT:		m_llInt = *(unsigned short *) pAddr; break;
+		case DATA_TYPE_INT:			m_llInt = *(int *) pAddr; break;
+		case DATA_TYPE_UINT:		m_llInt = *(unsigned int *) pAddr; break;
+		case DATA_TYPE_LONG:		m_llInt = *(long *) pAddr; break;
+		case DATA_TYPE_ULONG:		m_llInt = *(unsigned long *) pAddr; break;
+		case DATA_TYPE_LONG_LONG:	m_llInt = *(long long *) pAddr; break;
+		case DATA_TYPE_ULONG_LONG:	m_llInt = (long long) *(unsigned long long *) pAddr; break;
+		case DATA_TYPE_FLOAT:		m_dFloat = *(float *) pAddr; break;
+		case DATA_TYPE_DOUBLE:		m_dFloat = *(double *) pAddr; break;
+		case DATA_TYPE_POINTER:		m_llInt = (long long) *(unsigned long *) pAddr; break;
+		default: return;
+	}
+
+	if (IsFloatType(eType))
+		m_llInt = (long long) m_dFloat;
+	else
+		m_dFloat = (double) m_llInt;
+}
+
+void NativeValue_t::Store(void* pAddr, DataType_t eType) const
+{
+	switch(eType)
+	{
+		case DATA_TYPE_BOOL:		*(bool *) pAddr = m_llInt != 0; break;
+		case DATA_TYPE_CHAR:		*(char *) pAddr = (char) m_llInt; break;
+		case DATA_TYPE_UCHAR:		*(unsigned char *) pAddr = (unsigned char) m_llInt; break;
+		case DATA_TYPE_SHORT:		*(short *) pAddr = (short) m_llInt; break;
+		case DATA_TYPE_USHORT:		*(unsigned short *) pAddr = (unsigned short) m_llInt; break;
+		case DATA_TYPE_INT:			*(int *) pAddr = (int) m_llInt; break;
+		case DATA_TYPE_UINT:		*(unsigned int *) pAddr = (unsigned int) m_llInt; break;
+		case DATA_TYPE_LONG:		*(long *) pAddr = (long) m_llInt; break;
+		case DATA_TYPE_ULONG:		*(unsigned long *) pAddr = (unsigned long) m_llInt; break;
+		case DATA_TYPE_LONG_LONG:	*(long long *) pAddr = m_llInt; break;
+		case DATA_TYPE_ULONG_LONG:	*(unsigned long long *) pAddr = (unsigned long long) m_llInt; break;
+		case DATA_TYPE_FLOAT:		*(float *) pAddr = (float) m_dFloat; break;
+		case DATA_TYPE_DOUBLE:		*(double *) pAddr = m_dFloat; break;
+		case DATA_TYPE_POINTER:		*(unsigned long *) pAddr = (unsigned long) m_llInt; break;
+		default: break;
+	}
+}
+
+
+// ============================================================================
+// >> CNativeOperand
+// ============================================================================
+CNativeOperand::CNativeOperand(int iIndex, object oOffset, object oType)
+{
+	m_iIndex = iIndex;
+	m_bIndirect = !oOffset.is_none();
+	m_iOffset = m_bIndirect ? (int) extract<int>(oOffset) : 0;
+
+	if (m_bIndirect && oType.is_none())
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "A type is required if an offset is given.")
+
+	// Arguments and the return value are resolved when the hook is added
+	m_eType = oType.is_none() ? DATA_TYPE_VOID : (DataType_t) extract<DataType_t>(oType);
+}
+
+void CNativeOperand::Resolve(ICallingConvention* pConvention)
+{
+	DataType_t eType;
+	if (m_iIndex == NATIVE_RETURN_VALUE)
+	{
+		eType = pConvention->m_returnType;
+		if (eType == DATA_TYPE_VOID)
+			BOOST_RAISE_EXCEPTION(PyExc_ValueError, "The function doesn't return a value.")
+	}
+	else
+	{
+		if (m_iIndex < 0 || m_iIndex >= (int) pConvention->m_vecArgTypes.size())
+			BOOST_RAISE_EXCEPTION(PyExc_IndexError, "Index out of range.")
+
+		eType = pConvention->m_vecArgTypes[m_iIndex];
+	}
+
+	if (m_bIndirect)
+	{
+		if (eType != DATA_TYPE_POINTER)
+			BOOST_RAISE_EXCEPTION(PyExc_TypeError, "An offset requires a pointer operand.")
+	}
+	else if (m_eType == DATA_TYPE_VOID)
+	{
+		m_eType = eType;
+	}
+	else if (m_eType != eType)
+	{
+		BOOST_RAISE_EXCEPTION(PyExc_TypeError, "The given type doesn't match the type of the operand.")
+	}
+
+	if (m_eType == DATA_TYPE_VOID || m_eType == DATA_TYPE_STRING)
+		BOOST_RAISE_EXCEPTION(PyExc_TypeError, "Native hooks don't support operands of this type.")
+}
+
+void* CNativeOperand::GetAddress(CHook* pHook, void*& pDirect) const
+{
+	if (m_iIndex == NATIVE_RETURN_VALUE)
+		pDirect = pHook->m_pCallingConvention->GetReturnPtr(pHook->m_pRegisters);
+	else
+		pDirect = pHook->m_pCallingConvention->GetArgumentPtr(m_iIndex, pHook->m_pRegisters);
+
+	if (!m_bIndirect)
+		return pDirect;
+
+	unsigned long ulAddr = *(unsigned long *) pDirect;
+	if (!ulAddr)
+		return NULL;
+
+	return (void *) (ulAddr + m_iOffset);
+}
+
+bool CNativeOperand::Read(CHook* pHook, NativeValue_t& value) const
+{
+	void* pDirect;
+	void* pAddr = GetAddress(pHook, pDirect);
+	if (!pAddr)
+		return false;
+
+	value.Load(pAddr, m_eType);
+	return true;
+}
+
+bool CNativeOperand::Write(CHook* pHook, const NativeValue_t& value) const
+{
+	void* pDirect;
+	void* pAddr = GetAddress(pHook, pDirect);
+	if (!pAddr)
+		return false;
+
+	value.Store(pAddr, m_eType);
+
+	// The calling convention only needs to know about changed registers or
+	// stack slots, not about memory a pointer refers to.
+	if (!m_bIndirect)
+	{
+		if (m_iIndex == NATIVE_RETURN_VALUE)
+			pHook->m_pCallingConvention->ReturnPtrChanged(pHook->m_pRegisters, pDirect);
+		else
+			pHook->m_pCallingConvention->ArgumentPtrChanged(m_iIndex, pHook->m_pRegisters, pDirect);
+	}
+
+	return true;
+}
+
+bool CNativeOperand::operator==(const CNativeOperand& other) const
+{
+	return m_iIndex == other.m_iIndex && m_bIndirect == other.m_bIndirect
+		&& m_iOffset == other.m_iOffset && m_eType == other.m_eType;
+}
+
+
+// ============================================================================
+// >> CNativeCondition
+// ============================================================================
+CNativeCondition::CNativeCondition(int iIndex, NativeCompare_t eCompare, object oValue,
+	object oOffset /* = object() */, object oType /* = object() */)
+	:m_Operand(iIndex, oOffset, oType)
+{
+	m_eCompare = eCompare;
+	m_Value.m_llInt = 0;
+	m_Value.m_dFloat = 0;
+
+	if (eCompare != NATIVE_COMPARE_IN && eCompare != NATIVE_COMPARE_NOT_IN)
+	{
+		m_Value.FromPython(oValue);
+		return;
+	}
+
+	// Store the values as a bitset
+	object iterator = oValue.attr("__iter__")();
+	while (true)
+	{
+		object item;
+		try
+		{
+			item = iterator.attr("__next__")();
+		}
+		catch(error_already_set &)
+		{
+			if (!PyErr_ExceptionMatches(PyExc_StopIteration))
+				throw_error_already_set();
+
+			PyErr_Clear();
+			break;
+		}
+
+		long long llValue = extract<long long>(item);
+		if (llValue < 0)
+			BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Sets can only contain non-negative integers.")
+
+		if ((size_t) llValue >= m_vecSet.size())
+			m_vecSet.resize((size_t) llValue + 1, false);
+
+		m_vecSet[(size_t) llValue] = true;
+	}
+}
+
+bool CNativeCondition::Evaluate(CHook* pHook) const
+{
+	NativeValue_t value;
+	if (!m_Operand.Read(pHook, value))
+		return false;
+
+	if (m_eCompare == NATIVE_COMPARE_IN || m_eCompare == NATIVE_COMPARE_NOT_IN)
+	{
+		bool bContained = value.m_llInt >= 0 && (unsigned long long) value.m_llInt < m_vecSet.size()
+			&& m_vecSet[(size_t) value.m_llInt];
+
+		return bContained == (m_eCompare == NATIVE_COMPARE_IN);
+	}
+
+	if (IsFloatType(m_Operand.m_eType))
+		return Compare<double>(m_eCompare, value.m_dFloat, m_Value.m_dFloat);
+
+	return Compare<long long>(m_eCompare, value.m_llInt, m_Value.m_llInt);
+}
+
+bool CNativeCondition::operator==(const CNativeCondition& other) const
+{
+	return m_Operand == other.m_Operand && m_eCompare == other.m_eCompare
+		&& m_Value.m_llInt == other.m_Value.m_llInt && m_Value.m_dFloat == other.m_Value.m_dFloat
+		&& m_vecSet == other.m_vecSet;
+}
+
+
+// ============================================================================
+// >> CNativeAction
+// ============================================================================
+CNativeAction::CNativeAction(NativeActionType_t eAction, object oValue, int iIndex /* = NATIVE_RETURN_VALUE */,
+	object oOffset /* = object() */, object oType /* = object() */)
+	:m_Operand(eAction == NATIVE_ACTION_RETURN ? NATIVE_RETURN_VALUE : iIndex, oOffset, oType)
+{
+	if (eAction == NATIVE_ACTION_RETURN && m_Operand.m_bIndirect)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Return actions can't have an offset.")
+
+	m_eAction = eAction;
+	m_Value.FromPython(oValue);
+}
+
+bool CNativeAction::Execute(CHook* pHook) const
+{
+	if (m_eAction == NATIVE_ACTION_MIN || m_eAction == NATIVE_ACTION_MAX)
+	{
+		NativeValue_t value;
+		if (!m_Operand.Read(pHook, value))
+			return false;
+
+		NativeCompare_t eCompare = m_eAction == NATIVE_ACTION_MIN ? NATIVE_COMPARE_LESS : NATIVE_COMPARE_GREATER;
+		bool bClamp = IsFloatType(m_Operand.m_eType)
+			? Compare<double>(eCompare, value.m_dFloat, m_Value.m_dFloat)
+			: Compare<long long>(eCompare, value.m_llInt, m_Value.m_llInt);
+
+		if (!bClamp)
+			return false;
+	}
+
+	return m_Operand.Write(pHook, m_Value) && m_eAction == NATIVE_ACTION_RETURN;
+}
+
+bool CNativeAction::operator==(const CNativeAction& other) const
+{
+	return m_eAction == other.m_eAction && m_Operand == other.m_Operand
+		&& m_Value.m_llInt == other.m_Value.m_llInt && m_Value.m_dFloat == other.m_Value.m_dFloat;
+}
+
+
+// ============================================================================
+// >> CNativeHook
+// ============================================================================
+CNativeHook::CNativeHook(const CNativeAction& action, object oCondition)
+	:m_Action(action)
+{
+	if (!oCondition.is_none())
+		m_pCondition.reset(new CNativeCondition(extract<CNativeCondition&>(oCondition)));
+}
+
+void CNativeHook::Resolve(ICallingConvention* pConvention, HookType_t eHookType)
+{
+	m_Action.m_Operand.Resolve(pConvention);
+	if (m_pCondition)
+		m_pCondition->m_Operand.Resolve(pConvention);
+
+	// The return value isn't available before the original function was called
+	if (eHookType == HOOKTYPE_PRE)
+	{
+		if ((m_Action.m_eAction != NATIVE_ACTION_RETURN && m_Action.m_Operand.m_iIndex == NATIVE_RETURN_VALUE)
+			|| (m_pCondition && m_pCondition->m_Operand.m_iIndex == NATIVE_RETURN_VALUE))
+		{
+			BOOST_RAISE_EXCEPTION(PyExc_ValueError, "The return value can't be accessed in a pre-hook.")
+		}
+	}
+}
+
+bool CNativeHook::operator==(const CNativeHook& other) const
+{
+	if (!(m_Action == other.m_Action))
+		return false;
+
+	if (!m_pCondition || !other.m_pCondition)
+		return !m_pCondition && !other.m_pCondition;
+
+	return *m_pCondition == *other.m_pCondition;
+}
@@ -0,0 +1,212 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_NATIVE_HOOK_H
+#define _MEMORY_NATIVE_HOOK_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <vector>
+
+// DynamicHooks
+#include "hook.h"
+
+// Boost.Python
+#include "boost/python.hpp"
+using namespace boost::python;
+
+#include "boost/shared_ptr.hpp"
+
+
+// ============================================================================
+// >> CONSTANTS
+// ============================================================================
+// Use this index to refer to the return value instead of an argument
+#define NATIVE_RETURN_VALUE -1
+
+
+// ============================================================================
+// >> NativeCompare_t
+// ============================================================================
+enum NativeCompare_t
+{
+	NATIVE_COMPARE_EQUAL,
+	NATIVE_COMPARE_NOT_EQUAL,
+	NATIVE_COMPARE_LESS,
+	NATIVE_COMPARE_LESS_EQUAL,
+	NATIVE_COMPARE_GREATER,
+	NATIVE_COMPARE_GREATER_EQUAL,
+
+	// The value is a set of non-negative integers (e.g. indexes)
+	NATIVE_COMPARE_IN,
+	NATIVE_COMPARE_NOT_IN
+};
+
+
+// ============================================================================
+// >> NativeActionType_t
+// ============================================================================
+enum NativeActionType_t
+{
+	// Override the return value. In a pre-hook the original function is
+	// blocked as well.
+	NATIVE_ACTION_RETURN,
+
+	// Set the operand to the value
+	NATIVE_ACTION_SET,
+
+	// Raise the operand to the value if it's lower
+	NATIVE_ACTION_MIN,
+
+	// Lower the operand to the value if it's higher
+	NATIVE_ACTION_MAX
+};
+
+
+// ============================================================================
+// >> NativeValue_t
+// ============================================================================
+// A native value. It's stored as an integer and a float, because the type of
+// an argument is unknown until the hook is added.
+struct NativeValue_t
+{
+	long long	m_llInt;
+	double		m_dFloat;
+
+	void FromPython(object oValue);
+	void Load(void* pAddr, DataType_t eType);
+	void Store(void* pAddr, DataType_t eType) const;
+};
+
+
+// ============================================================================
+// >> CNativeOperand
+// ============================================================================
+// An argument or the return value of a hook. If an offset is given, the
+// operand is a pointer and the value is read from <pointer + offset>.
+class CNativeOperand
+{
+public:
+	CNativeOperand(int iIndex, object oOffset, object oType);
+
+	// Determines the type of the operand
+	void Resolve(ICallingConvention* pConvention);
+
+	bool Read(CHook* pHook, NativeValue_t& value) const;
+	bool Write(CHook* pHook, const NativeValue_t& value) const;
+
+	bool operator==(const CNativeOperand& other) const;
+
+private:
+	void* GetAddress(CHook* pHook, void*& pDirect) const;
+
+public:
+	int			m_iIndex;
+	int			m_iOffset;
+	bool		m_bIndirect;
+	DataType_t	m_eType;
+};
+
+
+// ============================================================================
+// >> CNativeCondition
+// ============================================================================
+class CNativeCondition
+{
+public:
+	CNativeCondition(int iIndex, NativeCompare_t eCompare, object oValue,
+		object oOffset=object(), object oType=object());
+
+	bool Evaluate(CHook* pHook) const;
+
+	bool operator==(const CNativeCondition& other) const;
+
+public:
+	CNativeOperand		m_Operand;
+	NativeCompare_t		m_eCompare;
+	NativeValue_t		m_Value;
+	std::vector<bool>	m_vecSet;
+};
+
+
+// ============================================================================
+// >> CNativeAction
+// ============================================================================
+class CNativeAction
+{
+public:
+	CNativeAction(NativeActionType_t eAction, object oValue, int iIndex=NATIVE_RETURN_VALUE,
+		object oOffset=object(), object oType=object());
+
+	// Returns true if the return value has been overridden
+	bool Execute(CHook* pHook) const;
+
+	bool operator==(const CNativeAction& other) const;
+
+public:
+	NativeActionType_t	m_eAction;
+	CNativeOperand		m_Operand;
+	NativeValue_t		m_Value;
+};
+
+
+// ============================================================================
+// >> CNativeHook
+// ============================================================================
+// An action and an optional condition that are evaluated without calling
+// into Python.
+class CNativeHook
+{
+public:
+	CNativeHook(const CNativeAction& action, object oCondition);
+
+	void Resolve(ICallingConvention* pConvention, HookType_t eHookType);
+
+	// Returns true if the return value has been overridden
+	bool Run(CHook* pHook) const
+	{
+		if (m_pCondition && !m_pCondition->Evaluate(pHook))
+			return false;
+
+		return m_Action.Execute(pHook);
+	}
+
+	bool operator==(const CNativeHook& other) const;
+
+public:
+	CNativeAction		m_Action;
+
+	// NULL if the action is always executed
+	boost::shared_ptr<CNativeCondition> m_pCondition;
+};
+
+typedef std::vector<CNativeHook> NativeHookVector;
+
+// Immutable snapshot of the native hooks of a hook type (see CallbackSnapshot)
+typedef boost::shared_ptr<const NativeHookVector> NativeHookSnapshot;
+
+#endif // _MEMORY_NATIVE_HOOK_H
@@ -29,7 +29,9 @@
 // ============================================================================
 // Memory
 #include "memory_pointer.h"
+#include "memory_search.h"
 #include "memory_utilities.h"
+#include "memory_vtable.h"
 
 // Utilities
 #include "utilities/call_python.h"
@@ -157,23 +159,7 @@ bool CPointer::IsOverlapping(object oOther, unsigned long ulNumBytes)
 void* SearchBytesHelper(unsigned char* base, unsigned char* end, unsigned char* bytes, unsigned long length)
 {	
 	TRY_SEGV()
-		while (base < end)
-		{
-			unsigned long i = 0;
-			for(; i < length; i++)
-			{
-				if (bytes[i] == '\x2A')
-					continue;
-
-				if (bytes[i] != base[i])
-					break;
-			}
-
-			if (i == length)
-				return base;
-
-			base++;
-		}
+		return SearchBytesRaw(base, end, bytes, length);
 	EXCEPT_SEGV()
 	return NULL;
 }
@@ -194,6 +180,21 @@ CPointer* CPointer::SearchBytes(object oBytes, unsigned long ulNumBytes)
 	return new CPointer((unsigned long) SearchBytesHelper(base, end, bytes, iByteLen));
 }
 
+object CPointer::AsMemoryView(unsigned long ulNumBytes, const char* szFormat /* = "B" */)
+{
+	Validate();
+	PyObject* pView = PyMemoryView_FromMemory((char *) m_ulAddr, ulNumBytes, PyBUF_WRITE);
+	if (!pView)
+		throw_error_already_set();
+
+	object view = object(handle<>(pView));
+	if (strcmp(szFormat, "B") == 0)
+		return view;
+
+	// Let Python validate the format and the size
+	return view.attr("cast")(szFormat);
+}
+
 void CopyHelper(void* dest, void* source, unsigned long length)
 {
 	TRY_SEGV()
@@ -256,6 +257,9 @@ CPointer* CPointer::GetVirtualFunc(int iIndex)
 
 CPointer* CPointer::Realloc(int iSize)
 { 
+	if (GetFrameArena()->Owns(m_ulAddr))
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Unable to reallocate memory of the frame arena.")
+
 	return new CPointer((unsigned long) UTIL_Realloc((void *) m_ulAddr, iSize)); 
 }
 
@@ -298,6 +302,33 @@ CFunction* CPointer::MakeVirtualFunction(CFunctionInfo& info)
 	);
 }
 
+CFunction* CPointer::MakeInstanceVirtualFunction(int iIndex, object oCallingConvention, object args, object return_type)
+{
+	Validate();
+	unsigned long ulStub = GetInstanceVTable(m_ulAddr, 0, true)->GetStub(iIndex);
+	return new CFunction(ulStub, oCallingConvention, args, return_type);
+}
+
+CFunction* CPointer::MakeInstanceVirtualFunction(CFunctionInfo& info)
+{
+	Validate();
+	if (!info.m_bIsVirtual)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Function is not a virtual function.")
+
+	return new CFunction(
+		GetInstanceVTable(m_ulAddr, info.m_iVtableOffset, true)->GetStub(info.m_iVtableIndex),
+		object(info.m_eCallingConvention),
+		info.GetArgumentTypes(),
+		object(info.m_eReturnType)
+	);
+}
+
+void CPointer::RestoreVirtualTable()
+{
+	Validate();
+	ReleaseInstanceVTable(m_ulAddr);
+}
+
 void CPointer::CallCallback(PyObject* self, char* szCallback)
 {
 	if (PyObject_HasAttrString(self, szCallback))
@@ -36,6 +36,8 @@ using namespace boost::python;
 
 // Memory
 #include "memory_alloc.h"
+#include "memory_arena.h"
+#include "memory_freelist.h"
 #include "memory_rtti.h"
 
 // Utilities
@@ -69,6 +71,10 @@ class CPointer
 {
 public:
 	CPointer(unsigned long ulAddr = 0, bool bAutoDealloc = false);
+
+	// Pointers are created for every pointer operation in Python (e.g.
+	// get_pointer() or adding an offset), so recycle their memory.
+	DECLARE_FREELIST_ALLOCATOR(CPointer)
 	
 	operator unsigned long() const { return m_ulAddr; }
 
@@ -144,6 +150,7 @@ public:
 
 	bool                IsOverlapping(object oOther, unsigned long ulNumBytes);
 	CPointer*           SearchBytes(object oBytes, unsigned long ulNumBytes);
+	object              AsMemoryView(unsigned long ulNumBytes, const char* szFormat = "B");
 
 	int                 Compare(object oOther, unsigned long ulNum);
 	void                Copy(object oDest, unsigned long ulNumBytes);
@@ -157,13 +164,25 @@ public:
 	CPointer*           GetVirtualFunc(int iIndex);
 
 	virtual CPointer*   Realloc(int iSize);
-	virtual void        Dealloc() { UTIL_Dealloc((void *) m_ulAddr); m_ulAddr = 0; }
+	virtual void        Dealloc()
+	{
+		// Arena allocations are released at the end of the frame
+		if (!GetFrameArena()->Owns(m_ulAddr))
+			UTIL_Dealloc((void *) m_ulAddr);
+
+		m_ulAddr = 0;
+	}
 
 	CFunction*			MakeFunction(CFunctionInfo& info);
 	CFunction*			MakeFunction(object oCallingConvention, object args, object return_type);
 	CFunction*			MakeVirtualFunction(int iIndex, object oCallingConvention, object args, object return_type);
 	CFunction*			MakeVirtualFunction(CFunctionInfo& info);
 
+	// Hooking the returned functions only affects this object
+	CFunction*			MakeInstanceVirtualFunction(int iIndex, object oCallingConvention, object args, object return_type);
+	CFunction*			MakeInstanceVirtualFunction(CFunctionInfo& info);
+	void				RestoreVirtualTable();
+
 	void				SetProtection(Protection_t prot, int size);
 	void				Protect(int size);
 	void				UnProtect(int size);
@@ -185,8 +204,11 @@ public:
 // ============================================================================
 // >> Alloc
 // ============================================================================
-inline CPointer* Alloc(int iSize, bool bAutoDealloc = true)
+inline CPointer* Alloc(int iSize, bool bAutoDealloc = true, bool bArena = false)
 {
+	if (bArena)
+		return new CPointer((unsigned long) GetFrameArena()->Alloc(iSize), false);
+
 	return new CPointer((unsigned long) UTIL_Alloc(iSize), bAutoDealloc);
 }
 
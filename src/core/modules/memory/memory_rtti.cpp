@@ -33,6 +33,9 @@
 #include <stdlib.h>
 #include <string>
 
+#include "boost/unordered_map.hpp"
+#include "boost/unordered_set.hpp"
+
 #ifdef WIN32
 struct _s_RTTIBaseClassDescriptor;
 typedef _s_RTTIBaseClassDescriptor ClassDescriptor;
@@ -41,6 +44,8 @@ class __class_type_info;
 typedef __class_type_info ClassDescriptor;
 #endif
 
+typedef boost::unordered_set<std::string> TypeNameSet;
+
 class CBaseType : public IBaseType
 {
 public:
@@ -54,6 +59,7 @@ public:
 		}
 
 		free(m_Bases);
+		delete m_Ancestors;
 	}
 
 	ptrdiff_t GetOffset()
@@ -84,7 +90,14 @@ public:
 
 	bool IsDerivedFrom(const char* name)
 	{
-		return IsClassDerivedFrom(this, name);
+		// The names of this type and all of its bases are collected on first use
+		if (!m_Ancestors)
+		{
+			m_Ancestors = new TypeNameSet();
+			AddAncestors(m_Ancestors);
+		}
+
+		return m_Ancestors->find(name) != m_Ancestors->end();
 	}
 
 	bool IsDerivedFrom(IBaseType* pType)
@@ -109,11 +122,22 @@ public:
 		}
 	}
 
+private:
+	void AddAncestors(TypeNameSet *ancestors)
+	{
+		ancestors->insert(GetName());
+		for (size_t i=0; i < m_BaseTypes; i++)
+		{
+			m_Bases[i].AddAncestors(ancestors);
+		}
+	}
+
 private:
 	ptrdiff_t m_Offset;
 	size_t m_BaseTypes;
 	CBaseType *m_Bases;
 	const std::type_info *m_TypeInfo;
+	TypeNameSet *m_Ancestors;
 };
 
 /* OS Specific Implementations */
@@ -210,6 +234,7 @@ _s_RTTICompleteObjectLocator *GetCompleteObjectLocator( const T *ptr) //not have
 
 CBaseType::CBaseType(const ClassDescriptor *descriptor, size_t offset)
 {
+	m_Ancestors = NULL;
 	m_BaseTypes = 0;
 	int basecount = descriptor->numBaseClasses;
 	int current = 1;
@@ -346,6 +371,7 @@ InheritanceType GetInheritanceType(const __class_type_info *ptr)
 
 CBaseType::CBaseType(const ClassDescriptor *descriptor, size_t offset)
 {
+	m_Ancestors = NULL;
 	InheritanceType type = GetInheritanceType(descriptor);
 
 	switch (type)
@@ -394,14 +420,34 @@ CBaseType::CBaseType(const ClassDescriptor *descriptor, size_t offset)
 }
 #endif
 
+// g_TypeCache[<type descriptor>] -> <IBaseType *>
+// Keyed by the descriptor instead of the virtual function table, because
+// the table might be a copy on the heap (see memory_vtable.h) that is freed
+// and reused. The descriptor is part of the module.
+typedef boost::unordered_map<const void *, IBaseType *> TypeCacheMap;
+TypeCacheMap g_TypeCache;
+
 IBaseType *GetType(const void *ptr)
 {
 #ifdef _WIN32
-	_s_RTTICompleteObjectLocator *locator = GetCompleteObjectLocator(ptr);
-	return new CBaseType(locator->pClassHierarchyDescriptor->pBaseClassArray[0], 0);
+	_s_RTTICompleteObjectLocator *descriptor = GetCompleteObjectLocator(ptr);
 #elif __linux__
-	return new CBaseType(typeid2(ptr), 0);
+	const __class_type_info *descriptor = typeid2(ptr);
 #else
 	#error Unsupported platform.
 #endif
+
+	// All objects of the same class share their type
+	TypeCacheMap::iterator it = g_TypeCache.find(descriptor);
+	if (it != g_TypeCache.end())
+		return it->second;
+
+#ifdef _WIN32
+	IBaseType *type = new CBaseType(descriptor->pClassHierarchyDescriptor->pBaseClassArray[0], 0);
+#else
+	IBaseType *type = new CBaseType(descriptor, 0);
+#endif
+
+	g_TypeCache[descriptor] = type;
+	return type;
 }
@@ -63,26 +63,11 @@ public:
 	virtual void Dump(int level) = 0;
 };
 
-/* Get type information for a class pointer */
+/* Get type information for a class pointer. The result is cached per class
+   and must not be deleted. */
 IBaseType *GetType(const void *ptr);
 
 /* Returns the classname for a given type - Removes platform specific formatting */
 const char *GetTypeName(const std::type_info &type);
 
-inline bool IsClassDerivedFrom(IBaseType* pBaseType, const char* name)
-{
-	for (size_t i = 0; i < pBaseType->GetNumBaseClasses(); i++)
-	{
-		if (strcmp(GetTypeName(pBaseType->GetTypeInfo()), name) == 0) {
-			return true;
-		}
-
-		if (IsClassDerivedFrom(pBaseType->GetBaseClass(i), name)) {
-			return true;
-		}
-	}
-
-	return false;
-}
-
 #endif // _MEMORY_RTTI_H
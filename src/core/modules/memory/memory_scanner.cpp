@@ -28,9 +28,12 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <stdio.h>
+#include <string>
+#include <vector>
 #ifdef _WIN32
 	#include <windows.h>
 #else
+	#include <dlfcn.h>
 	#include <fcntl.h>
 	#include <link.h>
 	#include <sys/mman.h>
@@ -41,16 +44,128 @@
 #include "dynload.h"
 
 #include "memory_scanner.h"
+#include "memory_search.h"
+#include "memory_utilities.h"
 #include "utilities/sp_util.h"
 #include "utilities/call_python.h"
 #include "sp_main.h"
 #include "eiface.h"
+#include "convar.h"
 
 
 //-----------------------------------------------------------------------------
 // Externals.
 //-----------------------------------------------------------------------------
 extern IVEngineServer* engine;
+extern const char *GetSourcePythonDir();
+extern ICvar* g_pCVar;
+
+
+//-----------------------------------------------------------------------------
+// Returns true if the SP logger would print messages of the given level.
+//-----------------------------------------------------------------------------
+static bool IsLoggingEnabled(int iLevel)
+{
+	static ConVar* s_pLoggingLevel = NULL;
+	if (!s_pLoggingLevel)
+		s_pLoggingLevel = g_pCVar->FindVar("sp_logging_level");
+
+	return !s_pLoggingLevel || s_pLoggingLevel->GetInt() >= iLevel;
+}
+
+
+//-----------------------------------------------------------------------------
+// Disk cache helpers
+//-----------------------------------------------------------------------------
+static std::string BytesToHex(const unsigned char* bytes, unsigned long ulLength)
+{
+	static const char* s_szDigits = "0123456789abcdef";
+
+	std::string result;
+	result.reserve(ulLength * 2);
+	for (unsigned long i=0; i < ulLength; i++)
+	{
+		result += s_szDigits[bytes[i] >> 4];
+		result += s_szDigits[bytes[i] & 0xF];
+	}
+	return result;
+}
+
+static bool HexToBytes(const char* szHex, std::string& result)
+{
+	result.clear();
+	unsigned int uiByte;
+	for (; szHex[0] && szHex[1]; szHex += 2)
+	{
+		if (sscanf(szHex, "%2x", &uiByte) != 1)
+			return false;
+
+		result += (char) uiByte;
+	}
+	return szHex[0] == '\0';
+}
+
+static std::string GetBinaryName(unsigned long ulModule)
+{
+#ifdef _WIN32
+	char szPath[MAX_PATH];
+	if (!GetModuleFileNameA((HMODULE) ulModule, szPath, MAX_PATH))
+		return std::string();
+
+	std::string path = szPath;
+#else
+	std::string path = ((struct link_map *) ulModule)->l_name;
+#endif
+	size_t pos = path.find_last_of("/\\");
+	return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+// Returns a string that changes whenever the binary is updated.
+static std::string GetBuildID(unsigned long ulModule, unsigned long ulBase, unsigned long ulSize)
+{
+	char szBuildID[64];
+#ifdef _WIN32
+	// The linker timestamp is unique enough for our purposes
+	IMAGE_DOS_HEADER* dos = (IMAGE_DOS_HEADER *) ulModule;
+	IMAGE_NT_HEADERS* nt  = (IMAGE_NT_HEADERS *) ((BYTE *) dos + dos->e_lfanew);
+	sprintf(szBuildID, "%08lx%08lx%08lx",
+		(unsigned long) nt->FileHeader.TimeDateStamp,
+		(unsigned long) nt->OptionalHeader.CheckSum,
+		(unsigned long) nt->OptionalHeader.SizeOfImage);
+#else
+	// Search the .note.gnu.build-id note in the loaded segments
+	Elf32_Ehdr* file = (Elf32_Ehdr *) ulBase;
+	Elf32_Phdr* phdr = (Elf32_Phdr *) (ulBase + file->e_phoff);
+	for (uint16_t i = 0; i < file->e_phnum; i++)
+	{
+		if (phdr[i].p_type != PT_NOTE)
+			continue;
+
+		unsigned char* note = (unsigned char *) (ulBase + phdr[i].p_vaddr);
+		unsigned char* end = note + phdr[i].p_memsz;
+		while (note + sizeof(Elf32_Nhdr) <= end)
+		{
+			Elf32_Nhdr* hdr = (Elf32_Nhdr *) note;
+			unsigned char* name = note + sizeof(Elf32_Nhdr);
+			unsigned char* desc = name + ((hdr->n_namesz + 3) & ~3);
+			if (hdr->n_type == NT_GNU_BUILD_ID && hdr->n_namesz == 4 && memcmp(name, "GNU", 4) == 0)
+				return BytesToHex(desc, hdr->n_descsz);
+
+			note = desc + ((hdr->n_descsz + 3) & ~3);
+		}
+	}
+
+	// No build ID available. Fall back to a hash (FNV-1a) of the code.
+	unsigned long long ullHash = 14695981039346656037ULL;
+	for (unsigned char* p = (unsigned char *) ulBase; p < (unsigned char *) ulBase + ulSize; p++)
+	{
+		ullHash ^= *p;
+		ullHash *= 1099511628211ULL;
+	}
+	sprintf(szBuildID, "fnv%016llx", ullHash);
+#endif
+	return szBuildID;
+}
 
 
 //-----------------------------------------------------------------------------
@@ -61,6 +176,82 @@ CBinaryFile::CBinaryFile(unsigned long ulModule, unsigned long ulBase, unsigned
 	m_ulModule = ulModule;
 	m_ulBase = ulBase;
 	m_ulSize = ulSize;
+	m_bCacheValid = false;
+	m_bSymbolIndexBuilt = false;
+
+	LoadDiskCache();
+}
+
+void CBinaryFile::LoadDiskCache()
+{
+	std::string szName = GetBinaryName(m_ulModule);
+	if (szName.empty())
+		return;
+
+	m_szCachePath = std::string(GetSourcePythonDir()) + "/data/source-python/memory/" + szName + ".cache";
+	m_szBuildID = GetBuildID(m_ulModule, m_ulBase, m_ulSize);
+
+	FILE* pFile = fopen(m_szCachePath.data(), "r");
+	if (!pFile)
+		return;
+
+	// The first line contains the build ID. If it doesn't match, the file
+	// is overwritten as soon as the first entry is added.
+	char szLine[4096];
+	char szType[16];
+	char szKey[4096];
+	if (!fgets(szLine, sizeof(szLine), pFile)
+		|| sscanf(szLine, "%15s %4095s", szType, szKey) != 2
+		|| strcmp(szType, "build_id") != 0
+		|| m_szBuildID != szKey)
+	{
+		PythonLog(4, "Discarding the outdated cache of %s.", szName.data());
+		fclose(pFile);
+		return;
+	}
+
+	m_bCacheValid = true;
+
+	std::string bytes;
+	unsigned long ulOffset;
+	while (fgets(szLine, sizeof(szLine), pFile))
+	{
+		if (sscanf(szLine, "%15s %4095s %lx", szType, szKey, &ulOffset) != 3)
+			continue;
+
+		if (strcmp(szType, "signature") == 0)
+		{
+			if (HexToBytes(szKey, bytes))
+				AddSignatureToCache((unsigned char *) bytes.data(), bytes.size(), m_ulBase + ulOffset, false);
+		}
+		else if (strcmp(szType, "symbol") == 0)
+			m_Symbols[szKey] = m_ulBase + ulOffset;
+	}
+
+	fclose(pFile);
+}
+
+void CBinaryFile::WriteDiskCache(const char* szType, const char* szKey, unsigned long ulAddr)
+{
+	if (m_szCachePath.empty())
+		return;
+
+	FILE* pFile = fopen(m_szCachePath.data(), m_bCacheValid ? "a" : "w");
+	if (!pFile)
+	{
+		PythonLog(2, "Failed to write the binary cache: %s", m_szCachePath.data());
+		m_szCachePath.clear();
+		return;
+	}
+
+	if (!m_bCacheValid)
+	{
+		fprintf(pFile, "build_id %s\n", m_szBuildID.data());
+		m_bCacheValid = true;
+	}
+
+	fprintf(pFile, "%s %s %lx\n", szType, szKey, ulAddr - m_ulBase);
+	fclose(pFile);
 }
 
 CPointer* CBinaryFile::FindSignatureRaw(object oSignature)
@@ -74,49 +265,33 @@ CPointer* CBinaryFile::FindSignatureRaw(object oSignature)
 	unsigned char* base = (unsigned char *) m_ulBase;
 	unsigned char* end  = (unsigned char *) (base + m_ulSize - iLength);
 
-	while(base < end)
-	{
-		int i = 0;
-		for(; i < iLength; i++)
-		{
-			if (sigstr[i] == '\x2A')
-				continue;
-
-			if (sigstr[i] != base[i])
-				break;
-		}
-
-		if (i == iLength)
-		{
-			return new CPointer((unsigned long) base);
-		}
-		base++;
-	}
-	return new CPointer();
+	return new CPointer((unsigned long) SearchBytesRaw(base, end, sigstr, iLength));
 }
 
-void CBinaryFile::AddSignatureToCache(unsigned char* sigstr, int iLength, unsigned int ulAddr)
+void CBinaryFile::AddSignatureToCache(unsigned char* sigstr, int iLength, unsigned long ulAddr, bool bPersist /* = true */)
 {
-	Signature_t sig_t = {new unsigned char[iLength+1], ulAddr};
-	strcpy((char*) sig_t.m_szSignature, (char*) sigstr);
-	m_Signatures.push_back(sig_t);
+	m_Signatures[std::string((char *) sigstr, iLength)] = ulAddr;
+
+	if (bPersist)
+		WriteDiskCache("signature", BytesToHex(sigstr, iLength).data(), ulAddr);
 }
 
-bool CBinaryFile::SearchSigInCache(unsigned char* sigstr, CPointer*& result)
+bool CBinaryFile::SearchSigInCache(unsigned char* sigstr, int iLength, CPointer*& result)
 {
-	PythonLog(4, "Searching for a cached signature...");
-	for (std::list<Signature_t>::iterator iter=m_Signatures.begin(); iter != m_Signatures.end(); ++iter)
+	SignatureMap::iterator iter = m_Signatures.find(std::string((char *) sigstr, iLength));
+	if (iter == m_Signatures.end())
 	{
-		Signature_t sig = *iter;
-		if (strcmp((const char *) sig.m_szSignature, (const char *) sigstr) == 0)
-		{
-			PythonLog(4, "Found a cached signature!");
-			result = new CPointer(sig.m_ulAddr);
-			return true;
-		}
+		if (IsLoggingEnabled(4))
+			PythonLog(4, "Could not find a cached signature.");
+
+		return false;
 	}
-	PythonLog(4, "Could not find a cached signature.");
-	return false;
+
+	if (IsLoggingEnabled(4))
+		PythonLog(4, "Found a cached signature!");
+
+	result = new CPointer(iter->second);
+	return true;
 }
 
 bool CBinaryFile::SearchSigInBinary(object oSignature, int iLength, unsigned char* sigstr, CPointer*& result)
@@ -171,11 +346,12 @@ CPointer* CBinaryFile::FindSignature(object oSignature)
 	if (!sigstr)
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Failed to read the given signature.");
 	
+	int iLength = len(oSignature);
+
 	CPointer* result = NULL;
-	if (SearchSigInCache(sigstr, result))
+	if (SearchSigInCache(sigstr, iLength, result))
 		return result;
-	
-	int iLength = len(oSignature);
+
 	if (SearchSigInBinary(oSignature, iLength, sigstr, result))
 		return result;
 
@@ -203,149 +379,189 @@ CPointer* CBinaryFile::FindSignature(object oSignature)
 	return new CPointer(); // To fix a warning. This will never get called.
 }
 
-CPointer* CBinaryFile::FindSymbol(char* szSymbol)
+dict CBinaryFile::FindSignatures(object oSignatures)
 {
-#ifdef _WIN32
-	void* pAddr = GetProcAddress((HMODULE) m_ulModule, szSymbol);
-	if (!pAddr)
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Could not find symbol: %s", szSymbol)
-
-	return new CPointer((unsigned long) pAddr);
+	dict result;
 
-#elif defined(__linux__)
-	dlerror();
-	void* pResult = dlsym((void*) m_ulModule, szSymbol);
-	if (!dlerror())
-		return new CPointer((unsigned long) pResult);
+	// Signatures that were not cached yet. Keep a reference to them, because
+	// the searcher only stores the pointers to their bytes.
+	std::vector<object> vecPending;
+	CMultiSearch search;
 
-	// -----------------------------------------
-	// We need to use mmap now that VALVe has
-	// made them all private!
-	// Thank you to DamagedSoul from AlliedMods
-	// for the following code.
-	// It can be found at:
-	// http://hg.alliedmods.net/sourcemod-central/file/dc361050274d/core/logic/MemoryUtils.cpp
-	// -----------------------------------------
-	struct link_map *dlmap;
-	struct stat dlstat;
-	int dlfile;
-	uintptr_t map_base;
-	Elf32_Ehdr *file_hdr;
-	Elf32_Shdr *sections, *shstrtab_hdr, *symtab_hdr, *strtab_hdr;
-	Elf32_Sym *symtab;
-	const char *shstrtab, *strtab;
-	uint16_t section_count;
-	uint32_t symbol_count;
+	object iterator = object(handle<>(PyObject_GetIter(oSignatures.ptr())));
+	PyObject* pItem;
+	while ((pItem = PyIter_Next(iterator.ptr())) != NULL)
+	{
+		object oSignature = object(handle<>(pItem));
+		unsigned char* sigstr = (unsigned char *) PyBytes_AsString(oSignature.ptr());
+		if (!sigstr)
+			BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Failed to read the given signature.");
 
-	dlmap = (struct link_map *) m_ulModule;
-	symtab_hdr = NULL;
-	strtab_hdr = NULL;
+		CPointer* pCached = NULL;
+		if (SearchSigInCache(sigstr, len(oSignature), pCached))
+		{
+			result[oSignature] = CPointer(pCached->m_ulAddr);
+			delete pCached;
+			continue;
+		}
 
-	dlfile = open(dlmap->l_name, O_RDONLY);
-	if (dlfile == -1 || fstat(dlfile, &dlstat) == -1)
-	{
-		close(dlfile);
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Failed to open file. Symbol: %s", szSymbol)
+		vecPending.push_back(oSignature);
+		search.AddPattern(sigstr, len(oSignature));
 	}
 
-	/* Map library file into memory */
-	file_hdr = (Elf32_Ehdr *)mmap(NULL, dlstat.st_size, PROT_READ, MAP_PRIVATE, dlfile, 0);
-	map_base = (uintptr_t)file_hdr;
-	close(dlfile);
-	if (file_hdr == MAP_FAILED)
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Failed to map file. Symbol: %s", szSymbol)
+	if (PyErr_Occurred())
+		throw_error_already_set();
 
-	if (file_hdr->e_shoff == 0 || file_hdr->e_shstrndx == SHN_UNDEF)
-	{
-		munmap(file_hdr, dlstat.st_size);
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "No section header string table has been found. Symbol: %s", szSymbol)
-	}
+	if (vecPending.empty())
+		return result;
 
-	sections = (Elf32_Shdr *)(map_base + file_hdr->e_shoff);
-	section_count = file_hdr->e_shnum;
-	/* Get ELF section header string table */
-	shstrtab_hdr = &sections[file_hdr->e_shstrndx];
-	shstrtab = (const char *)(map_base + shstrtab_hdr->sh_offset);
+	PythonLog(4, "Searching %i signatures in the binary...", (int) vecPending.size());
+	search.Search((unsigned char *) m_ulBase, m_ulSize);
 
-	/* Iterate sections while looking for ELF symbol table and string table */
-	for (uint16_t i = 0; i < section_count; i++)
+	// The signatures that were not found might be hooked. Their first bytes
+	// are then replaced by a relative (E9) or an absolute (FF25) jump.
+	std::vector<std::string> vecHooked;
+	vecHooked.reserve(vecPending.size() * 2);
+
+	std::vector<int> vecHookedIndexes;
+	CMultiSearch hooked_search;
+
+	for (size_t i=0; i < vecPending.size(); i++)
 	{
-		Elf32_Shdr &hdr = sections[i];
-		const char *section_name = shstrtab + hdr.sh_name;
+		object oSignature = vecPending[i];
+		unsigned char* sigstr = (unsigned char *) PyBytes_AsString(oSignature.ptr());
+		int iLength = len(oSignature);
 
-		if (strcmp(section_name, ".symtab") == 0)
-			symtab_hdr = &hdr;
+		unsigned char* pMatch = search.GetMatch((int) i);
+		if (pMatch)
+		{
+			AddSignatureToCache(sigstr, iLength, (unsigned long) pMatch);
+			result[oSignature] = CPointer((unsigned long) pMatch);
+			continue;
+		}
 
-		else if (strcmp(section_name, ".strtab") == 0)
-			strtab_hdr = &hdr;
-	}
+		int iRelative = -1;
+		int iAbsolute = -1;
+		if (iLength > 6)
+		{
+			vecHooked.push_back(std::string("\xE9\x2A\x2A\x2A\x2A", 5) + std::string((char *) sigstr + 5, iLength - 5));
+			iRelative = hooked_search.AddPattern((unsigned char *) vecHooked.back().data(), iLength);
+		}
 
-	/* Uh oh, we don't have a symbol table or a string table */
-	if (symtab_hdr == NULL || strtab_hdr == NULL)
-	{
-		munmap(file_hdr, dlstat.st_size);
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "No symbol table or string table found. Symbol: %s", szSymbol)
+		if (iLength > 7)
+		{
+			vecHooked.push_back(std::string("\xFF\x25\x2A\x2A\x2A\x2A", 6) + std::string((char *) sigstr + 6, iLength - 6));
+			iAbsolute = hooked_search.AddPattern((unsigned char *) vecHooked.back().data(), iLength);
+		}
+
+		vecHookedIndexes.push_back((int) i);
+		vecHookedIndexes.push_back(iRelative);
+		vecHookedIndexes.push_back(iAbsolute);
 	}
 
-	symtab = (Elf32_Sym *)(map_base + symtab_hdr->sh_offset);
-	strtab = (const char *)(map_base + strtab_hdr->sh_offset);
-	symbol_count = symtab_hdr->sh_size / symtab_hdr->sh_entsize;
+	if (vecHooked.empty())
+		return result;
 
-	/* Iterate symbol table starting from the position we were at last time */
-	for (uint32_t i = 0; i < symbol_count; i++)
-	{
-		Elf32_Sym &sym = symtab[i];
-		unsigned char sym_type = ELF32_ST_TYPE(sym.st_info);
-		const char *sym_name = strtab + sym.st_name;
+	PythonLog(4, "Searching %i hooked signatures in the binary...", (int) vecHooked.size());
+	hooked_search.Search((unsigned char *) m_ulBase, m_ulSize, true);
 
-		/* Skip symbols that are undefined or do not refer to functions or objects */
-		if (sym.st_shndx == SHN_UNDEF || (sym_type != STT_FUNC && sym_type != STT_OBJECT))
+	for (size_t i=0; i < vecHookedIndexes.size(); i += 3)
+	{
+		object oSignature = vecPending[vecHookedIndexes[i]];
+		int iRelative = vecHookedIndexes[i + 1];
+		int iAbsolute = vecHookedIndexes[i + 2];
+
+		// Same order as in FindSignature(). A hooked signature must be unique,
+		// otherwise it's treated as not found.
+		int iFound = -1;
+		if (iRelative != -1 && hooked_search.GetMatch(iRelative))
+			iFound = iRelative;
+		else if (iAbsolute != -1 && hooked_search.GetMatch(iAbsolute))
+			iFound = iAbsolute;
+
+		if (iFound == -1 || hooked_search.HasMultipleMatches(iFound))
 			continue;
 
-		if (strcmp(szSymbol, sym_name) == 0)
-		{
-			pResult = (void *)(dlmap->l_addr + sym.st_value);
-			break;
-		}
+		unsigned long ulAddr = (unsigned long) hooked_search.GetMatch(iFound);
+		AddSignatureToCache((unsigned char *) PyBytes_AsString(oSignature.ptr()), len(oSignature), ulAddr);
+		result[oSignature] = CPointer(ulAddr);
 	}
 
-	// Unmap the file now.
-	munmap(file_hdr, dlstat.st_size);
-	if (!pResult)
-		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Could not find symbol: %s", szSymbol)
+	return result;
+}
+
+CPointer* CBinaryFile::FindSymbol(char* szSymbol)
+{
+	boost::unordered_map<std::string, unsigned long>::iterator it = m_Symbols.find(szSymbol);
+	if (it != m_Symbols.end())
+		return new CPointer(it->second);
+
+	CPointer* pPtr = FindSymbolRaw(szSymbol);
+	m_Symbols[szSymbol] = pPtr->m_ulAddr;
 
-	return new CPointer((unsigned long) pResult);
+	// Symbols might be resolved to another binary. Their address relative
+	// to our base changes between restarts, so don't persist them.
+#ifdef _WIN32
+	HMODULE hModule;
+	if (GetModuleHandleExA(
+			GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			(LPCSTR) pPtr->m_ulAddr, &hModule)
+		&& (unsigned long) hModule == m_ulModule)
 #else
-#error "BinaryFile::FindSymbol() is not implemented on this OS"
+	Dl_info info;
+	if (dladdr((void *) pPtr->m_ulAddr, &info) && (unsigned long) info.dli_fbase == m_ulBase)
 #endif
+	{
+		WriteDiskCache("symbol", szSymbol, pPtr->m_ulAddr);
+	}
+
+	return pPtr;
 }
 
-CPointer* CBinaryFile::FindPointer(object oIdentifier, int iOffset, unsigned int iLevel)
+CPointer* CBinaryFile::FindSymbolRaw(char* szSymbol)
 {
-	CPointer* ptr = FindAddress(oIdentifier);
-	if (ptr->IsValid())
-	{
-		ptr->m_ulAddr += iOffset;
-		while (iLevel > 0)
-		{
-			ptr->m_ulAddr = GetPtrHelper(ptr->m_ulAddr);
-			iLevel = iLevel - 1;
-		}
-	}
-	return ptr;
+#ifdef _WIN32
+	void* pAddr = GetProcAddress((HMODULE) m_ulModule, szSymbol);
+	if (!pAddr)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Could not find symbol: %s", szSymbol)
+
+	return new CPointer((unsigned long) pAddr);
+
+#elif defined(__linux__)
+	dlerror();
+	void* pResult = dlsym((void*) m_ulModule, szSymbol);
+	if (!dlerror())
+		return new CPointer((unsigned long) pResult);
+
+	// VALVe made most of the symbols private, so we need to search the
+	// symbol table of the file.
+	BuildSymbolIndex();
+	SymbolMap::iterator iter = m_SymbolIndex.find(szSymbol);
+	if (iter == m_SymbolIndex.end())
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Could not find symbol: %s", szSymbol)
+
+	return new CPointer(iter->second);
+#else
+#error "BinaryFile::FindSymbolRaw() is not implemented on this OS"
+#endif
 }
 
-CPointer* CBinaryFile::FindAddress(object oIdentifier)
+void CBinaryFile::AddSymbolToIndex(const char* szName, unsigned long ulAddr, unsigned long ulSize)
 {
-	if(CheckClassname(oIdentifier, "bytes"))
-		return FindSignature(oIdentifier);
-	
-	return FindSymbol(extract<char*>(oIdentifier));
+	// Keep the first symbol, if there are several ones with the same name
+	std::pair<SymbolMap::iterator, bool> result = m_SymbolIndex.insert(std::make_pair(std::string(szName), ulAddr));
+	if (!result.second)
+		return;
+
+	SymbolInfo_t info = {&result.first->first, ulSize};
+	m_SymbolAddresses.insert(std::make_pair(ulAddr, info));
 }
 
-dict CBinaryFile::GetSymbols()
+void CBinaryFile::BuildSymbolIndex()
 {
-	dict result;
+	if (m_bSymbolIndexBuilt)
+		return;
+
 #ifdef _WIN32
 	PIMAGE_DOS_HEADER dos_header = (PIMAGE_DOS_HEADER) m_ulModule;
 	if (dos_header->e_magic != IMAGE_DOS_SIGNATURE)
@@ -358,24 +574,37 @@ dict CBinaryFile::GetSymbols()
 	if (nt_headers->OptionalHeader.NumberOfRvaAndSizes <= 0)
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Invalid number of directories in the optional header.")
 
-	PIMAGE_EXPORT_DIRECTORY exports = (PIMAGE_EXPORT_DIRECTORY) (
-		(BYTE *) m_ulModule
-		+ nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress);
+	IMAGE_DATA_DIRECTORY& export_dir = nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+	PIMAGE_EXPORT_DIRECTORY exports = (PIMAGE_EXPORT_DIRECTORY) ((BYTE *) m_ulModule + export_dir.VirtualAddress);
 
 	if (exports->AddressOfNames == NULL)
 		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Address of names is NULL.")
 
-	BYTE** symbols = (BYTE**)(m_ulModule + exports->AddressOfNames);
+	DWORD* names = (DWORD *) (m_ulModule + exports->AddressOfNames);
+	WORD* ordinals = (WORD *) (m_ulModule + exports->AddressOfNameOrdinals);
+	DWORD* functions = (DWORD *) (m_ulModule + exports->AddressOfFunctions);
 	for (DWORD i=0; i < exports->NumberOfNames; i++)
 	{
-		const char* name = (const char*) (m_ulModule + symbols[i]);
-
-		// TODO: Don't use GetProcAddress. There is probably a faster way
-		result[name] = CPointer((unsigned long) GetProcAddress((HMODULE) m_ulModule, name));
+		const char* name = (const char*) (m_ulModule + names[i]);
+		DWORD rva = functions[ordinals[i]];
+
+		// Forwarded exports point to a string inside of the export directory
+		unsigned long ulAddr;
+		if (rva >= export_dir.VirtualAddress && rva < export_dir.VirtualAddress + export_dir.Size)
+			ulAddr = (unsigned long) GetProcAddress((HMODULE) m_ulModule, name);
+		else
+			ulAddr = m_ulModule + rva;
+
+		// The export table doesn't know the size of a symbol
+		AddSymbolToIndex(name, ulAddr, 0);
 	}
 #elif __linux__
-	// TODO: Remove duplicated code. See also: FindSymbol()
-	
+	// -----------------------------------------
+	// Thank you to DamagedSoul from AlliedMods
+	// for the following code.
+	// It can be found at:
+	// http://hg.alliedmods.net/sourcemod-central/file/dc361050274d/core/logic/MemoryUtils.cpp
+	// -----------------------------------------
 	struct link_map *dlmap;
 	struct stat dlstat;
 	int dlfile;
@@ -441,25 +670,77 @@ dict CBinaryFile::GetSymbols()
 	strtab = (const char *)(map_base + strtab_hdr->sh_offset);
 	symbol_count = symtab_hdr->sh_size / symtab_hdr->sh_entsize;
 
-	/* Iterate symbol table starting from the position we were at last time */
+	/* Iterate the whole symbol table once and index it */
 	for (uint32_t i = 0; i < symbol_count; i++)
 	{
 		Elf32_Sym &sym = symtab[i];
 		unsigned char sym_type = ELF32_ST_TYPE(sym.st_info);
-		const char *sym_name = strtab + sym.st_name;
 
 		/* Skip symbols that are undefined or do not refer to functions or objects */
 		if (sym.st_shndx == SHN_UNDEF || (sym_type != STT_FUNC && sym_type != STT_OBJECT))
 			continue;
 
-		result[sym_name] = CPointer((unsigned long)(dlmap->l_addr + sym.st_value));
+		AddSymbolToIndex(strtab + sym.st_name, dlmap->l_addr + sym.st_value, sym.st_size);
 	}
 
-	// Unmap the file now.
+	// Unmap the file now. The index contains copies of the names.
 	munmap(file_hdr, dlstat.st_size);
 #else
 	#error Unsupported platform.
 #endif
+
+	m_bSymbolIndexBuilt = true;
+}
+
+object CBinaryFile::GetSymbolAt(object oAddress)
+{
+	unsigned long ulAddr = ExtractPointer(oAddress)->m_ulAddr;
+	BuildSymbolIndex();
+
+	// Get the last symbol that starts at or before the address
+	SymbolAddressMap::iterator iter = m_SymbolAddresses.upper_bound(ulAddr);
+	if (iter == m_SymbolAddresses.begin())
+		return object();
+
+	--iter;
+	SymbolInfo_t& info = iter->second;
+	if (ulAddr != iter->first && ulAddr >= iter->first + info.m_ulSize)
+		return object();
+
+	return str(info.m_pName->data());
+}
+
+CPointer* CBinaryFile::FindPointer(object oIdentifier, int iOffset, unsigned int iLevel)
+{
+	CPointer* ptr = FindAddress(oIdentifier);
+	if (ptr->IsValid())
+	{
+		ptr->m_ulAddr += iOffset;
+		while (iLevel > 0)
+		{
+			ptr->m_ulAddr = GetPtrHelper(ptr->m_ulAddr);
+			iLevel = iLevel - 1;
+		}
+	}
+	return ptr;
+}
+
+CPointer* CBinaryFile::FindAddress(object oIdentifier)
+{
+	if(CheckClassname(oIdentifier, "bytes"))
+		return FindSignature(oIdentifier);
+	
+	return FindSymbol(extract<char*>(oIdentifier));
+}
+
+dict CBinaryFile::GetSymbols()
+{
+	BuildSymbolIndex();
+
+	dict result;
+	for (SymbolMap::iterator iter=m_SymbolIndex.begin(); iter != m_SymbolIndex.end(); ++iter)
+		result[iter->first.data()] = CPointer(iter->second);
+
 	return result;
 }
 
@@ -478,6 +759,22 @@ bool str_ends_with(const char *szString, const char *szSuffix)
 	return strncmp(szString + stringlen - suffixlen, szSuffix, suffixlen) == 0;
 }
 
+// Returns the key for the path cache. Windows paths are case insensitive.
+static std::string NormalizeBinaryPath(const std::string& szPath)
+{
+	std::string result = szPath;
+#ifdef _WIN32
+	for (std::string::iterator it=result.begin(); it != result.end(); ++it)
+	{
+		if (*it == '\\')
+			*it = '/';
+		else
+			*it = tolower(*it);
+	}
+#endif
+	return result;
+}
+
 CBinaryFile* CBinaryManager::FindBinary(char* szPath, bool bSrvCheck /* = true */, bool bCheckExtension /* = true */)
 {
 	std::string szBinaryPath = szPath;
@@ -490,6 +787,12 @@ CBinaryFile* CBinaryManager::FindBinary(char* szPath, bool bSrvCheck /* = true *
 	}
 #endif
 
+	// Repeated lookups of the same path don't need to call the loader
+	std::string szKey = NormalizeBinaryPath(szBinaryPath);
+	BinaryPathMap::iterator cached = m_BinaryPaths.find(szKey);
+	if (cached != m_BinaryPaths.end())
+		return cached->second;
+
 	unsigned long ulModule = (unsigned long) dlLoadLibrary(szBinaryPath.data());
 	unsigned long ulBase = 0;
 #ifdef __linux__
@@ -523,6 +826,7 @@ CBinaryFile* CBinaryManager::FindBinary(char* szPath, bool bSrvCheck /* = true *
 		{
 			// We don't need to open it several times
 			dlFreeLibrary((DLLib *) ulModule);
+			m_BinaryPaths[szKey] = binary;
 			return binary;
 		}
 	}
@@ -601,6 +905,7 @@ CBinaryFile* CBinaryManager::FindBinary(char* szPath, bool bSrvCheck /* = true *
 	// Create a new Binary object and add it to the list
 	CBinaryFile* binary = new CBinaryFile(ulModule, ulBase, ulSize);
 	m_Binaries.push_front(binary);
+	m_BinaryPaths[szKey] = binary;
 	return binary;
 }
 
@@ -31,15 +31,28 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <list>
+#include <map>
+#include <string>
+#include "boost/unordered_map.hpp"
 #include "export_main.h"
 #include "memory_pointer.h"
 
-struct Signature_t
+// Maps the exact bytes of a signature to its address
+typedef boost::unordered_map<std::string, unsigned long> SignatureMap;
+
+// Maps the name of a symbol to its address
+typedef boost::unordered_map<std::string, unsigned long> SymbolMap;
+
+struct SymbolInfo_t
 {
-	unsigned char* m_szSignature;
-	unsigned long  m_ulAddr;
+	// Points to the key in the SymbolMap
+	const std::string*	m_pName;
+	unsigned long		m_ulSize;
 };
 
+// Maps the address of a symbol to its name and size
+typedef std::map<unsigned long, SymbolInfo_t> SymbolAddressMap;
+
 
 class CBinaryFile
 {
@@ -49,16 +62,30 @@ public:
 	CPointer* FindSignatureRaw(object oSignature);
 
 	CPointer* FindSignature(object oSignature);
+	dict FindSignatures(object oSignatures);
 	CPointer* FindSymbol(char* szSymbol);
+	CPointer* FindSymbolRaw(char* szSymbol);
 	CPointer* FindPointer(object oIdentifier, int iOffset, unsigned int iLevel);
 	CPointer* FindAddress(object oIdentifier);
 
 	dict GetSymbols();
+	object GetSymbolAt(object oAddress);
 
 private:
-	void AddSignatureToCache(unsigned char* sigstr, int iLength, unsigned int ulAddr);
+	void AddSignatureToCache(unsigned char* sigstr, int iLength, unsigned long ulAddr, bool bPersist=true);
+
+	// The disk cache stores the address (relative to m_ulBase) of every
+	// signature and symbol that was found. It's only used if the build ID of
+	// the binary didn't change since it was written.
+	void LoadDiskCache();
+	void WriteDiskCache(const char* szType, const char* szKey, unsigned long ulAddr);
 
-	bool SearchSigInCache(unsigned char* sigstr, CPointer*& result);
+	// Reads all symbols of the binary once (export table on Windows,
+	// .symtab on Linux).
+	void BuildSymbolIndex();
+	void AddSymbolToIndex(const char* szName, unsigned long ulAddr, unsigned long ulSize);
+
+	bool SearchSigInCache(unsigned char* sigstr, int iLength, CPointer*& result);
 	bool SearchSigInBinary(object oSignature, int iLength, unsigned char* sigstr, CPointer*& result);
 	bool SearchSigHooked(object oSignature, int iLength, unsigned char* sigstr, CPointer*& result);
 
@@ -66,10 +93,22 @@ public:
 	unsigned long			m_ulModule;
 	unsigned long			m_ulBase;
 	unsigned long			m_ulSize;
-	std::list<Signature_t>	m_Signatures;
+	SignatureMap			m_Signatures;
+	SymbolMap				m_Symbols;
+
+	bool					m_bSymbolIndexBuilt;
+	SymbolMap				m_SymbolIndex;
+	SymbolAddressMap		m_SymbolAddresses;
+
+	std::string				m_szCachePath;
+	std::string				m_szBuildID;
+	bool					m_bCacheValid;
 };
 
 
+// Maps the normalized path that was passed to FindBinary() to the binary
+typedef boost::unordered_map<std::string, CBinaryFile*> BinaryPathMap;
+
 class CBinaryManager
 {
 public:
@@ -77,6 +116,7 @@ public:
 
 private:
 	std::list<CBinaryFile*> m_Binaries;
+	BinaryPathMap			m_BinaryPaths;
 };
 
 static CBinaryManager* s_pBinaryManager = new CBinaryManager();
@@ -0,0 +1,437 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <vector>
+
+// Memory
+#include "memory_search.h"
+
+#ifdef _WIN32
+	#include <intrin.h>
+#else
+	#include <cpuid.h>
+#endif
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+
+// ============================================================================
+// >> MACROS
+// ============================================================================
+// The module is compiled with SSE only, so the vector code paths have to be
+// enabled per function. MSVC allows using any intrinsic without that.
+#ifdef _WIN32
+	#define TARGET_SSE2
+	#define TARGET_AVX2
+#else
+	#define TARGET_SSE2 __attribute__((target("sse2")))
+	#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define WILDCARD_BYTE 0x2A
+
+
+// ============================================================================
+// >> CPU DETECTION
+// ============================================================================
+enum SearchLevel_t
+{
+	SEARCH_LEVEL_SCALAR,
+	SEARCH_LEVEL_SSE2,
+	SEARCH_LEVEL_AVX2
+};
+
+static void GetCPUID(unsigned int uiLeaf, unsigned int regs[4])
+{
+#ifdef _WIN32
+	__cpuidex((int *) regs, uiLeaf, 0);
+#else
+	__cpuid_count(uiLeaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long GetXCR0()
+{
+#ifdef _WIN32
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long) edx << 32) | eax;
+#endif
+}
+
+static SearchLevel_t DetectSearchLevel()
+{
+	unsigned int regs[4];
+	GetCPUID(0, regs);
+	unsigned int uiMaxLeaf = regs[0];
+	if (uiMaxLeaf < 1)
+		return SEARCH_LEVEL_SCALAR;
+
+	GetCPUID(1, regs);
+	if (!(regs[3] & (1 << 26)))
+		return SEARCH_LEVEL_SCALAR;
+
+	// AVX2 requires the CPU to support it and the OS to save the YMM registers
+	bool bOSXSave = (regs[2] & (1 << 27)) != 0;
+	bool bAVX = (regs[2] & (1 << 28)) != 0;
+	if (!bOSXSave || !bAVX || uiMaxLeaf < 7 || (GetXCR0() & 0x6) != 0x6)
+		return SEARCH_LEVEL_SSE2;
+
+	GetCPUID(7, regs);
+	if (!(regs[1] & (1 << 5)))
+		return SEARCH_LEVEL_SSE2;
+
+	return SEARCH_LEVEL_AVX2;
+}
+
+static SearchLevel_t GetSearchLevel()
+{
+	static int s_iSearchLevel = -1;
+	if (s_iSearchLevel == -1)
+		s_iSearchLevel = DetectSearchLevel();
+
+	return (SearchLevel_t) s_iSearchLevel;
+}
+
+static inline unsigned int CountTrailingZeros(unsigned int uiValue)
+{
+#ifdef _WIN32
+	unsigned long ulIndex;
+	_BitScanForward(&ulIndex, uiValue);
+	return ulIndex;
+#else
+	return __builtin_ctz(uiValue);
+#endif
+}
+
+
+// ============================================================================
+// >> CSearchPattern
+// ============================================================================
+// Precomputed information about the pattern that is shared by all scanners.
+class CSearchPattern
+{
+public:
+	CSearchPattern(const unsigned char* bytes, unsigned long length)
+	{
+		m_pBytes = bytes;
+		m_ulLength = length;
+		m_ulAnchor = 0;
+		m_ulAnchorLength = 0;
+
+		// Every 0x2A gets a 0xFF in the mask, so it can be ORed with the
+		// result of a byte compare.
+		m_vecWildcards.resize(length);
+
+		unsigned long ulRunStart = 0;
+		for (unsigned long i=0; i < length; i++)
+		{
+			if (bytes[i] == WILDCARD_BYTE)
+			{
+				m_vecWildcards[i] = 0xFF;
+				ulRunStart = i + 1;
+				continue;
+			}
+
+			m_vecWildcards[i] = 0;
+
+			// The longest non-wildcard run is the anchor, because it has the
+			// least false positives.
+			if (i + 1 - ulRunStart > m_ulAnchorLength)
+			{
+				m_ulAnchor = ulRunStart;
+				m_ulAnchorLength = i + 1 - ulRunStart;
+			}
+		}
+	}
+
+	unsigned char FirstAnchorByte() const
+	{ return m_pBytes[m_ulAnchor]; }
+
+	unsigned char LastAnchorByte() const
+	{ return m_pBytes[m_ulAnchor + m_ulAnchorLength - 1]; }
+
+	// Offset of the last anchor byte relative to the candidate address.
+	unsigned long LastAnchorOffset() const
+	{ return m_ulAnchor + m_ulAnchorLength - 1; }
+
+	bool MatchesScalar(const unsigned char* base) const
+	{
+		for (unsigned long i=0; i < m_ulLength; i++)
+		{
+			if (m_pBytes[i] != WILDCARD_BYTE && m_pBytes[i] != base[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool Matches(const unsigned char* base) const
+	{
+		if (GetSearchLevel() == SEARCH_LEVEL_SCALAR)
+			return MatchesScalar(base);
+
+		return MatchesSSE2(base);
+	}
+
+	TARGET_SSE2 bool MatchesSSE2(const unsigned char* base) const
+	{
+		const unsigned char* pWildcards = &m_vecWildcards[0];
+
+		unsigned long i = 0;
+		for (; i + 16 <= m_ulLength; i += 16)
+		{
+			__m128i equal = _mm_cmpeq_epi8(
+				_mm_loadu_si128((const __m128i *) (base + i)),
+				_mm_loadu_si128((const __m128i *) (m_pBytes + i)));
+
+			__m128i result = _mm_or_si128(equal, _mm_loadu_si128((const __m128i *) (pWildcards + i)));
+			if (_mm_movemask_epi8(result) != 0xFFFF)
+				return false;
+		}
+
+		for (; i < m_ulLength; i++)
+		{
+			if (!pWildcards[i] && m_pBytes[i] != base[i])
+				return false;
+		}
+		return true;
+	}
+
+public:
+	const unsigned char*		m_pBytes;
+	unsigned long				m_ulLength;
+	unsigned long				m_ulAnchor;
+	unsigned long				m_ulAnchorLength;
+	std::vector<unsigned char>	m_vecWildcards;
+};
+
+
+// ============================================================================
+// >> SCANNERS
+// ============================================================================
+static unsigned char* SearchScalar(unsigned char* base, unsigned char* end, const CSearchPattern& pattern)
+{
+	for (; base < end; base++)
+	{
+		if (pattern.MatchesScalar(base))
+			return base;
+	}
+	return NULL;
+}
+
+// Both vector scanners compare the first and the last anchor byte for a block
+// of candidates at once and only verify the candidates where both matched.
+TARGET_SSE2 static unsigned char* SearchSSE2(unsigned char* base, unsigned char* end, const CSearchPattern& pattern)
+{
+	const __m128i first = _mm_set1_epi8((char) pattern.FirstAnchorByte());
+	const __m128i last = _mm_set1_epi8((char) pattern.LastAnchorByte());
+	const unsigned long ulFirst = pattern.m_ulAnchor;
+	const unsigned long ulLast = pattern.LastAnchorOffset();
+
+	for (; end - base >= 16; base += 16)
+	{
+		__m128i eq_first = _mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i *) (base + ulFirst)));
+		__m128i eq_last = _mm_cmpeq_epi8(last, _mm_loadu_si128((const __m128i *) (base + ulLast)));
+
+		unsigned int uiMask = _mm_movemask_epi8(_mm_and_si128(eq_first, eq_last));
+		while (uiMask)
+		{
+			unsigned int uiBit = CountTrailingZeros(uiMask);
+			if (pattern.MatchesSSE2(base + uiBit))
+				return base + uiBit;
+
+			uiMask &= uiMask - 1;
+		}
+	}
+
+	for (; base < end; base++)
+	{
+		if (pattern.MatchesSSE2(base))
+			return base;
+	}
+	return NULL;
+}
+
+TARGET_AVX2 static unsigned char* SearchAVX2(unsigned char* base, unsigned char* end, const CSearchPattern& pattern)
+{
+	const __m256i first = _mm256_set1_epi8((char) pattern.FirstAnchorByte());
+	const __m256i last = _mm256_set1_epi8((char) pattern.LastAnchorByte());
+	const unsigned long ulFirst = pattern.m_ulAnchor;
+	const unsigned long ulLast = pattern.LastAnchorOffset();
+
+	for (; end - base >= 32; base += 32)
+	{
+		__m256i eq_first = _mm256_cmpeq_epi8(first, _mm256_loadu_si256((const __m256i *) (base + ulFirst)));
+		__m256i eq_last = _mm256_cmpeq_epi8(last, _mm256_loadu_si256((const __m256i *) (base + ulLast)));
+
+		unsigned int uiMask = (unsigned int) _mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last));
+		while (uiMask)
+		{
+			unsigned int uiBit = CountTrailingZeros(uiMask);
+			if (pattern.MatchesSSE2(base + uiBit))
+				return base + uiBit;
+
+			uiMask &= uiMask - 1;
+		}
+	}
+
+	// Avoid the AVX/SSE transition penalty in the remaining SSE2 code
+	_mm256_zeroupper();
+	return SearchSSE2(base, end, pattern);
+}
+
+
+// ============================================================================
+// >> SearchBytesRaw
+// ============================================================================
+unsigned char* SearchBytesRaw(unsigned char* base, unsigned char* end,
+	const unsigned char* bytes, unsigned long length)
+{
+	if (base >= end)
+		return NULL;
+
+	CSearchPattern pattern(bytes, length);
+
+	// Only wildcards. Every address matches.
+	if (pattern.m_ulAnchorLength == 0)
+		return base;
+
+	switch (GetSearchLevel())
+	{
+		case SEARCH_LEVEL_AVX2: return SearchAVX2(base, end, pattern);
+		case SEARCH_LEVEL_SSE2: return SearchSSE2(base, end, pattern);
+	}
+	return SearchScalar(base, end, pattern);
+}
+
+
+// ============================================================================
+// >> CMultiSearch
+// ============================================================================
+CMultiSearch::CMultiSearch()
+{
+}
+
+CMultiSearch::~CMultiSearch()
+{
+	for (std::vector<Entry_t>::iterator it=m_vecEntries.begin(); it != m_vecEntries.end(); ++it)
+		delete it->m_pPattern;
+}
+
+int CMultiSearch::AddPattern(const unsigned char* bytes, unsigned long length)
+{
+	Entry_t entry;
+	entry.m_pPattern = new CSearchPattern(bytes, length);
+	entry.m_pMatch = NULL;
+	entry.m_bMultiple = false;
+
+	int iIndex = (int) m_vecEntries.size();
+	m_vecEntries.push_back(entry);
+
+	// Patterns that only consist of wildcards are handled in Search()
+	if (entry.m_pPattern->m_ulAnchorLength != 0)
+		m_Buckets[entry.m_pPattern->FirstAnchorByte()].push_back(iIndex);
+
+	return iIndex;
+}
+
+void CMultiSearch::Search(unsigned char* base, unsigned long size, bool bFindDuplicates)
+{
+	// A pattern is done when its first match was found, or its second one if
+	// duplicates are searched as well.
+	int iPending = (int) m_vecEntries.size();
+	for (std::vector<Entry_t>::iterator it=m_vecEntries.begin(); it != m_vecEntries.end(); ++it)
+	{
+		it->m_pMatch = NULL;
+		it->m_bMultiple = false;
+
+		CSearchPattern* pPattern = it->m_pPattern;
+		if (pPattern->m_ulAnchorLength != 0)
+			continue;
+
+		if (pPattern->m_ulLength < size)
+		{
+			it->m_pMatch = base;
+			it->m_bMultiple = pPattern->m_ulLength + pPattern->m_ulLength < size;
+		}
+		iPending--;
+	}
+
+	// Every byte of the region is looked up once. The patterns of the bucket
+	// have their first anchor byte at this position and are verified if the
+	// candidate fits into the region.
+	for (unsigned long ulOffset=0; ulOffset < size && iPending > 0; ulOffset++)
+	{
+		std::vector<int>& bucket = m_Buckets[base[ulOffset]];
+		for (std::vector<int>::iterator it=bucket.begin(); it != bucket.end(); ++it)
+		{
+			Entry_t& entry = m_vecEntries[*it];
+			CSearchPattern* pPattern = entry.m_pPattern;
+			if (entry.m_bMultiple || (entry.m_pMatch && !bFindDuplicates))
+				continue;
+
+			if (ulOffset < pPattern->m_ulAnchor)
+				continue;
+
+			// Same range as SearchBytesRaw(base, base + size - length, ...)
+			unsigned long ulCandidate = ulOffset - pPattern->m_ulAnchor;
+			if (ulCandidate + pPattern->m_ulLength >= size)
+				continue;
+
+			// Matches must not overlap
+			unsigned char* pCandidate = base + ulCandidate;
+			if (entry.m_pMatch && pCandidate < entry.m_pMatch + pPattern->m_ulLength)
+				continue;
+
+			if (!pPattern->Matches(pCandidate))
+				continue;
+
+			if (!entry.m_pMatch)
+				entry.m_pMatch = pCandidate;
+			else
+				entry.m_bMultiple = true;
+
+			if (entry.m_bMultiple || !bFindDuplicates)
+				iPending--;
+		}
+	}
+}
+
+unsigned char* CMultiSearch::GetMatch(int iIndex) const
+{
+	return m_vecEntries[iIndex].m_pMatch;
+}
+
+bool CMultiSearch::HasMultipleMatches(int iIndex) const
+{
+	return m_vecEntries[iIndex].m_bMultiple;
+}
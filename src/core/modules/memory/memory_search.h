@@ -0,0 +1,94 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_SEARCH_H
+#define _MEMORY_SEARCH_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <vector>
+
+
+// ============================================================================
+// >> SearchBytesRaw
+// ============================================================================
+// Returns the first address in [base, end) where the given bytes match. A byte
+// with the value 0x2A is treated as a wildcard. The caller has to make sure
+// that <length> bytes are readable at every address in that range.
+//
+// The fastest implementation supported by the CPU (AVX2, SSE2 or a plain
+// byte loop) is picked the first time this function is called.
+unsigned char* SearchBytesRaw(unsigned char* base, unsigned char* end,
+	const unsigned char* bytes, unsigned long length);
+
+
+// ============================================================================
+// >> CMultiSearch
+// ============================================================================
+class CSearchPattern;
+
+// Searches any number of patterns (same wildcard rules as SearchBytesRaw) in
+// a single pass over a memory region. The pattern bytes are not copied, so
+// they must stay alive until the search is done.
+class CMultiSearch
+{
+public:
+	CMultiSearch();
+	~CMultiSearch();
+
+	// Returns the index of the new pattern.
+	int AddPattern(const unsigned char* bytes, unsigned long length);
+
+	// Searches all patterns in [base, base + size). If bFindDuplicates is
+	// true, the search continues after the first match of a pattern to find
+	// out whether it's unique.
+	void Search(unsigned char* base, unsigned long size, bool bFindDuplicates=false);
+
+	// Returns the first match of the pattern or NULL.
+	unsigned char* GetMatch(int iIndex) const;
+
+	// Returns true if the pattern was found more than once.
+	bool HasMultipleMatches(int iIndex) const;
+
+private:
+	CMultiSearch(const CMultiSearch&);
+	CMultiSearch& operator=(const CMultiSearch&);
+
+	struct Entry_t
+	{
+		CSearchPattern*	m_pPattern;
+		unsigned char*	m_pMatch;
+		bool			m_bMultiple;
+	};
+
+	std::vector<Entry_t>	m_vecEntries;
+
+	// Pattern indexes, grouped by the first byte of their anchor
+	std::vector<int>		m_Buckets[256];
+};
+
+#endif // _MEMORY_SEARCH_H
@@ -0,0 +1,264 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <link.h>
+#endif
+
+#include "boost/unordered_map.hpp"
+
+// Memory
+#include "memory_vtable.h"
+#include "memory_hooks.h"
+#include "memory_exception.h"
+#include "utilities/wrap_macros.h"
+
+// DynamicHooks
+#include "utilities.h"
+
+
+// ============================================================================
+// >> CONSTANTS
+// ============================================================================
+// Number of entries in front of a table. GCC stores the offset-to-top and
+// the RTTI pointer there, MSVC only the RTTI pointer.
+#define VTABLE_HEADER_SIZE 2
+
+// Stop at this size in case the end of a table can't be detected
+#define MAX_VTABLE_SIZE 1024
+
+// jmp dword ptr [<stub + 8>], 2 bytes padding, <target>, 4 bytes padding
+#define STUB_SIZE 16
+#define STUB_TARGET_OFFSET 8
+
+
+// ============================================================================
+// >> GLOBAL VARIABLES
+// ============================================================================
+// g_mapInstanceVTables[<instance>][<offset of the table pointer>] -> <CInstanceVTable *>
+typedef std::map<int, CInstanceVTable *> VTableOffsetMap;
+typedef boost::unordered_map<unsigned long, VTableOffsetMap> InstanceVTableMap;
+InstanceVTableMap g_mapInstanceVTables;
+
+
+// ============================================================================
+// >> HELPER FUNCTIONS
+// ============================================================================
+#ifndef _WIN32
+struct ExecutableSearch_t
+{
+	unsigned long	m_ulAddr;
+	bool			m_bFound;
+};
+
+int FindExecutableSegment(dl_phdr_info* info, size_t size, void* data)
+{
+	ExecutableSearch_t* pSearch = (ExecutableSearch_t *) data;
+	for (int i=0; i < info->dlpi_phnum; i++)
+	{
+		const ElfW(Phdr)& hdr = info->dlpi_phdr[i];
+		if (hdr.p_type != PT_LOAD || !(hdr.p_flags & PF_X))
+			continue;
+
+		unsigned long ulStart = info->dlpi_addr + hdr.p_vaddr;
+		if (pSearch->m_ulAddr >= ulStart && pSearch->m_ulAddr < ulStart + hdr.p_memsz)
+		{
+			pSearch->m_bFound = true;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+#endif
+
+bool IsExecutableAddress(void* pAddr)
+{
+	if (!pAddr)
+		return false;
+
+#ifdef _WIN32
+	MEMORY_BASIC_INFORMATION info;
+	if (!VirtualQuery(pAddr, &info, sizeof(info)) || info.State != MEM_COMMIT)
+		return false;
+
+	return (info.Protect & (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) != 0;
+#else
+	// Tables are followed by the offset-to-top and the RTTI pointer of the
+	// next table or other data. Neither of them points to code.
+	ExecutableSearch_t search;
+	search.m_ulAddr = (unsigned long) pAddr;
+	search.m_bFound = false;
+	dl_iterate_phdr(&FindExecutableSegment, &search);
+	return search.m_bFound;
+#endif
+}
+
+void** GetVTableHelper(unsigned long ulInstance)
+{
+	TRY_SEGV()
+		return *(void ***) ulInstance;
+	EXCEPT_SEGV()
+	return NULL;
+}
+
+
+// ============================================================================
+// >> CInstanceVTable
+// ============================================================================
+CInstanceVTable::CInstanceVTable(unsigned long ulInstance)
+{
+	m_pOriginal = GetVTableHelper(ulInstance);
+	if (!m_pOriginal)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Failed to get the virtual function table.")
+
+	m_iSize = GetTableSize(m_pOriginal);
+	if (!m_iSize)
+		BOOST_RAISE_EXCEPTION(PyExc_ValueError, "Failed to determine the size of the virtual function table.")
+
+	m_ulInstance = ulInstance;
+	m_pBuffer = new void*[VTABLE_HEADER_SIZE + m_iSize];
+	memcpy(m_pBuffer, m_pOriginal - VTABLE_HEADER_SIZE, (VTABLE_HEADER_SIZE + m_iSize) * sizeof(void *));
+
+	// Let the instance use the copy
+	m_pTable = m_pBuffer + VTABLE_HEADER_SIZE;
+	*(void ***) m_ulInstance = m_pTable;
+}
+
+CInstanceVTable::~CInstanceVTable()
+{
+	for (std::map<int, unsigned char*>::iterator it=m_Stubs.begin(); it != m_Stubs.end(); ++it)
+	{
+		CHook* pHook = FindHook((void *) it->second);
+		if (pHook)
+		{
+			DeleteHookCallbacks(pHook);
+
+			// The Function objects still own the calling convention
+			pHook->m_pCallingConvention = NULL;
+			UnhookFunction((void *) it->second);
+		}
+	}
+
+	if (IsInstalled())
+		*(void ***) m_ulInstance = m_pOriginal;
+
+	for (std::map<int, unsigned char*>::iterator it=m_Stubs.begin(); it != m_Stubs.end(); ++it)
+		delete[] it->second;
+
+	delete[] m_pBuffer;
+}
+
+int CInstanceVTable::GetTableSize(void** pTable)
+{
+	int iSize = 0;
+	TRY_SEGV()
+		while (iSize < MAX_VTABLE_SIZE && IsExecutableAddress(pTable[iSize]))
+			iSize++;
+	EXCEPT_SEGV()
+	return iSize;
+}
+
+bool CInstanceVTable::IsInstalled()
+{
+	return GetVTableHelper(m_ulInstance) == m_pTable;
+}
+
+unsigned long CInstanceVTable::GetStub(int iIndex)
+{
+	if (iIndex < 0 || iIndex >= m_iSize)
+		BOOST_RAISE_EXCEPTION(PyExc_IndexError, "Index out of range.")
+
+	std::map<int, unsigned char*>::iterator it = m_Stubs.find(iIndex);
+	if (it != m_Stubs.end())
+		return (unsigned long) it->second;
+
+	unsigned char* pStub = new unsigned char[STUB_SIZE];
+	SetMemPatchable(pStub, STUB_SIZE);
+
+	// The jump uses an absolute address, so DynamicHooks can copy it to the
+	// trampoline as it is
+	memset(pStub, 0xCC, STUB_SIZE);
+	pStub[0] = 0xFF;
+	pStub[1] = 0x25;
+	*(void **) (pStub + 2) = pStub + STUB_TARGET_OFFSET;
+	*(void **) (pStub + STUB_TARGET_OFFSET) = m_pOriginal[iIndex];
+
+	m_pTable[iIndex] = pStub;
+	m_Stubs[iIndex] = pStub;
+	return (unsigned long) pStub;
+}
+
+
+// ============================================================================
+// >> FUNCTIONS
+// ============================================================================
+CInstanceVTable* GetInstanceVTable(unsigned long ulInstance, int iOffset /* = 0 */, bool bCreate /* = false */)
+{
+	InstanceVTableMap::iterator it = g_mapInstanceVTables.find(ulInstance);
+	if (it != g_mapInstanceVTables.end())
+	{
+		VTableOffsetMap::iterator table = it->second.find(iOffset);
+		if (table != it->second.end())
+		{
+			if (table->second->IsInstalled())
+				return table->second;
+
+			// The object has been replaced without releasing the table
+			delete table->second;
+			it->second.erase(table);
+		}
+
+		if (!bCreate && it->second.empty())
+			g_mapInstanceVTables.erase(it);
+	}
+
+	if (!bCreate)
+		return NULL;
+
+	CInstanceVTable* pVTable = new CInstanceVTable(ulInstance + iOffset);
+	g_mapInstanceVTables[ulInstance][iOffset] = pVTable;
+	return pVTable;
+}
+
+void ReleaseInstanceVTable(unsigned long ulInstance)
+{
+	InstanceVTableMap::iterator it = g_mapInstanceVTables.find(ulInstance);
+	if (it == g_mapInstanceVTables.end())
+		return;
+
+	for (VTableOffsetMap::iterator table=it->second.begin(); table != it->second.end(); ++table)
+		delete table->second;
+
+	g_mapInstanceVTables.erase(it);
+}
@@ -0,0 +1,85 @@
+/**
+* =============================================================================
+* Source Python
+* Copyright (C) 2012-2015 Source Python Development Team.  All rights reserved.
+* =============================================================================
+*
+* This program is free software; you can redistribute it and/or modify it under
+* the terms of the GNU General Public License, version 3.0, as published by the
+* Free Software Foundation.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+* details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* As a special exception, the Source Python Team gives you permission
+* to link the code of this program (as well as its derivative works) to
+* "Half-Life 2," the "Source Engine," and any Game MODs that run on software
+* by the Valve Corporation.  You must obey the GNU General Public License in
+* all respects for all other code used.  Additionally, the Source.Python
+* Development Team grants this exception to all derivative works.
+*/
+
+#ifndef _MEMORY_VTABLE_H
+#define _MEMORY_VTABLE_H
+
+// ============================================================================
+// >> INCLUDES
+// ============================================================================
+#include <map>
+
+
+// ============================================================================
+// >> CInstanceVTable
+// ============================================================================
+// A copy of the virtual function table of a single object. Every slot that
+// should be hookable points to a small stub that jumps to the original
+// function. Since each stub has its own address, hooking it with
+// DynamicHooks only affects this object.
+class CInstanceVTable
+{
+public:
+	CInstanceVTable(unsigned long ulInstance);
+	~CInstanceVTable();
+
+	// Returns the address of the stub for the given slot. The stub is created
+	// on first use.
+	unsigned long GetStub(int iIndex);
+
+	// Returns true if the instance still uses the copied table
+	bool IsInstalled();
+
+private:
+	static int GetTableSize(void** pTable);
+
+public:
+	// Address of the table pointer within the object
+	unsigned long	m_ulInstance;
+	void**			m_pOriginal;
+	int				m_iSize;
+
+	// Includes the entries in front of the table (offset-to-top and RTTI)
+	void**			m_pBuffer;
+	void**			m_pTable;
+
+	// m_Stubs[<slot>] -> <stub>
+	std::map<int, unsigned char*> m_Stubs;
+};
+
+
+// ============================================================================
+// >> FUNCTIONS
+// ============================================================================
+// Returns the copy of the table whose pointer is stored at the given offset
+// of the instance. Objects with multiple inheritance have more than one.
+CInstanceVTable* GetInstanceVTable(unsigned long ulInstance, int iOffset = 0, bool bCreate = false);
+
+// Unhooks all stubs and restores the original tables of the instance. Call
+// this before the object is deleted.
+void ReleaseInstanceVTable(unsigned long ulInstance);
+
+#endif // _MEMORY_VTABLE_H
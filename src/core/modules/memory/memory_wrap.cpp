@@ -37,6 +37,8 @@
 #include "memory_utilities.h"
 #include "memory_wrap.h"
 #include "memory_rtti.h"
+#include "memory_attribute.h"
+#include "memory_arena.h"
 
 // DynamicHooks
 #include "registers.h"
@@ -54,6 +56,7 @@ void export_data_type_t(scope);
 void export_convention_t(scope);
 void export_hook_type_t(scope);
 void export_stack_data(scope);
+void export_hook_stats(scope);
 void export_register_t(scope);
 void export_register(scope);
 void export_registers(scope);
@@ -61,6 +64,9 @@ void export_calling_convention(scope);
 void export_functions(scope);
 void export_global_variables(scope);
 void export_protection(scope);
+void export_native_attribute(scope);
+void export_native_hook(scope);
+void export_frame_arena(scope);
 
 
 // ============================================================================
@@ -69,6 +75,7 @@ void export_protection(scope);
 DECLARE_SP_MODULE(_memory)
 {
 	SetHooksDisabled(false);
+	SetHookThread();
 
 	export_function_info(_memory);
 	export_binary_file(_memory);
@@ -80,6 +87,7 @@ DECLARE_SP_MODULE(_memory)
 	export_convention_t(_memory);
 	export_hook_type_t(_memory);
 	export_stack_data(_memory);
+	export_hook_stats(_memory);
 	export_register_t(_memory);
 	export_register(_memory);
 	export_registers(_memory);
@@ -87,6 +95,9 @@ DECLARE_SP_MODULE(_memory)
 	export_functions(_memory);
 	export_global_variables(_memory);
 	export_protection(_memory);
+	export_native_attribute(_memory);
+	export_native_hook(_memory);
+	export_frame_arena(_memory);
 }
 
 
@@ -129,6 +140,25 @@ void export_binary_file(scope _memory)
 			manage_new_object_policy()
 		)
 
+		.def("find_signatures",
+			&CBinaryFile::FindSignatures,
+			"Search all given signatures in a single pass over the binary.\n\n"
+			":param iterable signatures: The signatures (bytes) to search.\n"
+			":return: A dict that maps every found signature to its address. Signatures "
+			"that could not be found are not added.\n"
+			":rtype: dict",
+			args("signatures")
+		)
+
+		.def("symbol_at",
+			&CBinaryFile::GetSymbolAt,
+			"Return the name of the symbol that contains the given address.\n\n"
+			":param Pointer address: The address to look up.\n"
+			":return: The name of the symbol or ``None`` if no symbol contains the address.\n"
+			":rtype: str",
+			args("address")
+		)
+
 		// Special methods
 		.def("__getitem__",
 			&CBinaryFile::FindAddress,
@@ -264,6 +294,27 @@ void export_pointer(scope _memory)
 			manage_new_object_policy()
 		)
 
+		.def("make_instance_virtual_function",
+			GET_METHOD(CFunction*, CPointer, MakeInstanceVirtualFunction, int, object, object, object),
+			"Creates a new Function instance for a virtual function of this object only. "
+			"The virtual function table of this object is replaced with a copy, so hooking the returned function doesn't affect other objects.",
+			args("index", "convention", "arguments", "return_type"),
+			manage_new_object_policy()
+		)
+
+		.def("make_instance_virtual_function",
+			GET_METHOD(CFunction*, CPointer, MakeInstanceVirtualFunction, CFunctionInfo&),
+			"Use the given FunctionInfo object to create a Function instance for a virtual function of this object only.",
+			("info"),
+			manage_new_object_policy()
+		)
+
+		.def("restore_virtual_table",
+			&CPointer::RestoreVirtualTable,
+			"Removes all hooks created with make_instance_virtual_function() and restores the original virtual function table. "
+			"This is done automatically when an entity is deleted."
+		)
+
 		.def("realloc",
 			&CPointer::PreRealloc,
 			"Reallocates a memory block.",
@@ -305,6 +356,17 @@ void export_pointer(scope _memory)
 			manage_new_object_policy()
 		)
 
+		.def("as_memoryview",
+			&CPointer::AsMemoryView,
+			"Return a memoryview of the first <num_bytes> of this memory block without copying them.\n\n"
+			":param int num_bytes: Size of the view in bytes. It must be a multiple of the item size.\n"
+			":param str format: A native struct format character (e.g. ``'f'`` or ``'i'``) for the items.\n"
+			":rtype: memoryview\n\n"
+			".. warning::\n\n"
+			"    The view doesn't keep the memory alive. Don't use it after the memory has been freed.",
+			("num_bytes", arg("format")="B")
+		)
+
 		.def("copy",
 			&CPointer::Copy,
 			"Copies <num_bytes> from <self> to the pointer <destination>. Overlapping is not allowed!",
@@ -387,7 +449,7 @@ void export_pointer(scope _memory)
 
 		// Properties
 		.add_property("type_info",
-			make_function(&CPointer::GetTypeInfo, manage_new_object_policy())
+			make_function(&CPointer::GetTypeInfo, reference_existing_object_policy())
 		)
 	;
 }
@@ -457,10 +519,16 @@ void export_function(scope _memory)
 		// Don't allow copies, because they will hold references to our calling convention.
 		// .def(init<CFunction&>())
 		.def("__call__",
-			raw_method(&CFunction::Call),
+			raw_function(&CFunctionExt::Call<&CFunction::Call>, 1),
 			"Calls the function dynamically."
 		)
 
+		.def("call_many",
+			&CFunction::CallMany,
+			"Calls the function once for every argument sequence and returns a list of the return values.",
+			args("arguments")
+		)
+
 		.def("is_callable",
 			&CFunction::IsCallable,
 			"Return True if the function is callable."
@@ -477,19 +545,20 @@ void export_function(scope _memory)
 		)
 
 		.def("call_trampoline",
-			raw_method(&CFunction::CallTrampoline),
+			raw_function(&CFunctionExt::Call<&CFunction::CallTrampoline>, 1),
 			"Calls the trampoline function dynamically."
 		)
 
 		.def("skip_hooks",
-			raw_method(&CFunction::SkipHooks),
+			raw_function(&CFunctionExt::Call<&CFunction::SkipHooks>, 1),
 			"Call the function, but skip hooks if there are any."
 		)
 
 		.def("add_hook",
 			&CFunction::AddHook,
-			"Adds a hook callback.",
-			args("hook_type", "callback")
+			"Adds a hook callback. Callbacks with a higher priority are called first. "
+			"If stop_on_override is True, the remaining callbacks are skipped when this callback overrides the return value.",
+			(arg("hook_type"), arg("callback"), arg("priority")=0, arg("stop_on_override")=false)
 		)
 
 		.def("remove_hook",
@@ -500,12 +569,14 @@ void export_function(scope _memory)
 
 		.def("add_pre_hook",
 			&CFunction::AddPreHook,
-			"Adds a pre-hook callback."
+			"Adds a pre-hook callback. See :meth:`add_hook`.",
+			(arg("callback"), arg("priority")=0, arg("stop_on_override")=false)
 		)
 
 		.def("add_post_hook",
 			&CFunction::AddPostHook,
-			"Adds a post-hook callback."
+			"Adds a post-hook callback. See :meth:`add_hook`.",
+			(arg("callback"), arg("priority")=0, arg("stop_on_override")=false)
 		)
 
 		.def("remove_pre_hook",
@@ -518,6 +589,33 @@ void export_function(scope _memory)
 			"Removes a post-hook callback."
 		)
 
+		.def("add_deferred_post_hook",
+			&CFunction::AddDeferredPostHook,
+			"Adds a post-hook callback that is called at the end of the frame. "
+			"The arguments and the return value of every call are copied, and the callback is called once with a list of "
+			"``(<args>, <return value>)`` tuples. Its return value is ignored. "
+			"Pointers (including ``this``) are passed as integers, because the objects they point to have usually been freed at the end of the frame. "
+			"They must not be dereferenced.",
+			(arg("callback"), arg("priority")=0)
+		)
+
+		.def("remove_deferred_post_hook",
+			&CFunction::RemoveDeferredPostHook,
+			"Removes a deferred post-hook callback."
+		)
+
+		.def("add_native_hook",
+			&CFunction::AddNativeHook,
+			"Adds an action that is executed without calling into Python. Native hooks are executed before the hook callbacks.",
+			(arg("hook_type"), arg("action"), arg("condition")=object())
+		)
+
+		.def("remove_native_hook",
+			&CFunction::RemoveNativeHook,
+			"Removes a native hook that was added with the same action and condition.",
+			(arg("hook_type"), arg("action"), arg("condition")=object())
+		)
+
 		.def("_delete_hook",
 			&CFunction::DeleteHook,
 			"Removes all hooks and restores the original function."
@@ -540,6 +638,17 @@ void export_function(scope _memory)
 			&CFunction::m_eCallingConvention
 		)
 
+		.add_property("hook_stats",
+			&CFunction::GetHookStats,
+			"Return the recorded stats of the hook. See :func:`get_hook_stats`.\n\n"
+			":rtype: dict"
+		)
+
+		.def_readwrite("thread_safe",
+			&CFunction::m_bThreadSafe,
+			"Set to True if the native function is thread-safe. The GIL is then released while it's running."
+		)
+
 		// Properties
 		.add_property("trampoline",
 			make_function(&CFunction::GetTrampoline, manage_new_object_policy()),
@@ -598,7 +707,12 @@ void export_hook_type_t(scope _memory)
 	enum_<HookType_t>("HookType")
 		.value("PRE", HOOKTYPE_PRE)
 		.value("POST", HOOKTYPE_POST)
+		.value("POST_DEFERRED", HOOKTYPE_POST_DEFERRED)
 	;
+
+	// A unique object that hook callbacks can return to skip the remaining callbacks
+	g_pHookStop = PyObject_CallObject((PyObject *) &PyBaseObject_Type, NULL);
+	_memory.attr("HOOK_STOP") = object(handle<>(borrowed(g_pHookStop)));
 }
 
 
@@ -635,6 +749,40 @@ void export_stack_data(scope _memory)
 }
 
 
+// ============================================================================
+// >> HookStats_t
+// ============================================================================
+void export_hook_stats(scope _memory)
+{
+	class_<HookStats_t>("HookStats", "Recorded stats of a hook or hook callback. Times are in seconds.")
+		.def_readonly("calls",
+			&HookStats_t::m_ulCalls
+		)
+
+		.def_readonly("overrides",
+			&HookStats_t::m_ulOverrides,
+			"Number of calls that overrode the return value."
+		)
+
+		.def_readonly("total_time",
+			&HookStats_t::m_dTotalTime
+		)
+
+		.def_readonly("min_time",
+			&HookStats_t::m_dMinTime
+		)
+
+		.def_readonly("max_time",
+			&HookStats_t::m_dMaxTime
+		)
+
+		.add_property("average_time",
+			&HookStats_t::GetAverageTime
+		)
+	;
+}
+
+
 // ============================================================================
 // >> Register_t
 // ============================================================================
@@ -925,11 +1073,13 @@ void export_functions(scope _memory)
 	
 	def("alloc",
 		Alloc,
-		("size", arg("auto_dealloc")=true),
+		("size", arg("auto_dealloc")=true, arg("arena")=false),
 		"Allocate a memory block.\n"
 		"\n"
 		":param int size: The size (in bytes) of the memory block.\n"
-		":param bool auto_dealloc: If True the memory block will be deallocated automatically when the return value goes out of the scope.",
+		":param bool auto_dealloc: If True the memory block will be deallocated automatically when the return value goes out of the scope.\n"
+		":param bool arena: If True the memory block is allocated from :attr:`frame_arena` and released at the end of the current frame. "
+			"``auto_dealloc`` is ignored in that case. Use :meth:`FrameArena.persist` to keep the data for longer.",
 		manage_new_object_policy()
 	);
 
@@ -987,6 +1137,30 @@ void export_functions(scope _memory)
 		"Set whether or not hook callbacks are disabled.\n"
 		"\n"
 		":param bool disabled: If ``True``, hook callbacks are disabled.");
+
+	def("get_hook_profiling",
+		&GetHookProfiling,
+		"Return whether or not hook calls are profiled.\n"
+		"\n"
+		":rtype: bool");
+
+	def("set_hook_profiling",
+		&SetHookProfiling,
+		"Set whether or not hook calls are profiled.\n"
+		"\n"
+		":param bool enabled: If ``True``, the time spent in hooks is recorded.");
+
+	def("get_hook_stats",
+		&GetAllHookStats,
+		"Return the recorded stats of all hooks.\n"
+		"\n"
+		":return: ``{(<address>, <HookType>, <callback or None>): <HookStats>}``. "
+		"The entry without a callback contains the stats of the whole hook.\n"
+		":rtype: dict");
+
+	def("reset_hook_stats",
+		&ResetHookStats,
+		"Reset the recorded stats of all hooks.");
 }
 
 
@@ -1043,3 +1217,164 @@ void export_protection(scope _memory)
 	Protection.value("EXECUTE_READ", PROTECTION_EXECUTE_READ);
 	Protection.value("EXECUTE_READ_WRITE", PROTECTION_EXECUTE_READ_WRITE);
 }
+
+
+// ============================================================================
+// >> CNativeAttribute
+// ============================================================================
+void export_native_attribute(scope _memory)
+{
+	class_<CNativeAttribute>(
+		"NativeAttribute",
+		"A descriptor that accesses a native value of a Pointer (sub)class instance.",
+		init<DataType_t, int, optional<unsigned int> >(
+			(arg("type"), arg("offset"), arg("level")=0),
+			":param DataType type: The type of the value.\n"
+			":param int offset: The offset of the value (or the pointer to it).\n"
+			":param int level: The number of pointers that need to be dereferenced to reach the value."
+		)
+	)
+		.def("__get__",
+			&CNativeAttribute::__get__
+		)
+
+		.def("__set__",
+			&CNativeAttribute::__set__
+		)
+
+		.def_readonly("type",
+			&CNativeAttribute::m_eType,
+			"The type of the value."
+		)
+
+		.def_readonly("offset",
+			&CNativeAttribute::m_iOffset,
+			"The offset of the value (or the pointer to it)."
+		)
+
+		.def_readonly("level",
+			&CNativeAttribute::m_uiLevel,
+			"The number of pointers that need to be dereferenced to reach the value."
+		)
+	;
+}
+
+
+// ============================================================================
+// >> CNativeHook
+// ============================================================================
+void export_native_hook(scope _memory)
+{
+	enum_<NativeCompare_t>("NativeCompare")
+		.value("EQUAL", NATIVE_COMPARE_EQUAL)
+		.value("NOT_EQUAL", NATIVE_COMPARE_NOT_EQUAL)
+		.value("LESS", NATIVE_COMPARE_LESS)
+		.value("LESS_EQUAL", NATIVE_COMPARE_LESS_EQUAL)
+		.value("GREATER", NATIVE_COMPARE_GREATER)
+		.value("GREATER_EQUAL", NATIVE_COMPARE_GREATER_EQUAL)
+		.value("IN", NATIVE_COMPARE_IN)
+		.value("NOT_IN", NATIVE_COMPARE_NOT_IN)
+	;
+
+	enum_<NativeActionType_t>("NativeActionType")
+		.value("RETURN", NATIVE_ACTION_RETURN)
+		.value("SET", NATIVE_ACTION_SET)
+		.value("MIN", NATIVE_ACTION_MIN)
+		.value("MAX", NATIVE_ACTION_MAX)
+	;
+
+	class_<CNativeCondition>(
+		"NativeCondition",
+		"A condition of a native hook.",
+		init<int, NativeCompare_t, object, optional<object, object> >(
+			(arg("index"), arg("compare"), arg("value"), arg("offset")=object(), arg("type")=object()),
+			":param int index: The index of the argument or NATIVE_RETURN_VALUE.\n"
+			":param NativeCompare compare: How the operand is compared with the value.\n"
+			":param value: The value to compare with. NativeCompare.IN and NativeCompare.NOT_IN require an iterable of non-negative integers.\n"
+			":param int offset: If given, the operand is a pointer and the value at this offset is compared.\n"
+			":param DataType type: The type of the value at the offset."
+		)
+	)
+		.def_readonly("compare",
+			&CNativeCondition::m_eCompare
+		)
+	;
+
+	class_<CNativeAction>(
+		"NativeAction",
+		"An action of a native hook.",
+		init<NativeActionType_t, object, optional<int, object, object> >(
+			(arg("action"), arg("value"), arg("index")=NATIVE_RETURN_VALUE, arg("offset")=object(), arg("type")=object()),
+			":param NativeActionType action: The action to execute.\n"
+			":param value: The value to return, set or clamp to.\n"
+			":param int index: The index of the argument or NATIVE_RETURN_VALUE. Ignored for NativeActionType.RETURN.\n"
+			":param int offset: If given, the operand is a pointer and the value at this offset is modified.\n"
+			":param DataType type: The type of the value at the offset."
+		)
+	)
+		.def_readonly("action",
+			&CNativeAction::m_eAction
+		)
+	;
+
+	_memory.attr("NATIVE_RETURN_VALUE") = NATIVE_RETURN_VALUE;
+}
+
+
+// ============================================================================
+// >> CFrameArena
+// ============================================================================
+void export_frame_arena(scope _memory)
+{
+	class_<CFrameArena, boost::noncopyable>(
+		"FrameArena",
+		"Memory blocks that are allocated from this arena are released at the end of every frame.",
+		no_init)
+
+		.def("persist",
+			&CFrameArena::Persist,
+			"Copy an allocation of the current frame to a new memory block that is deallocated automatically.\n"
+			"\n"
+			":param Pointer ptr: The allocation to copy.\n"
+			":rtype: Pointer\n"
+			":raise ValueError: Raised if the pointer isn't the start of an allocation of the current frame.",
+			(arg("ptr")),
+			manage_new_object_policy()
+		)
+
+		.def("is_live",
+			&CFrameArena::IsLive,
+			"Return True if the address belongs to an allocation of the current frame.\n"
+			"\n"
+			":param int address: The address to check.\n"
+			":rtype: bool",
+			(arg("address"))
+		)
+
+		.def("owns",
+			&CFrameArena::Owns,
+			"Return True if the address belongs to the arena, even if it has already been released.\n"
+			"\n"
+			":param int address: The address to check.\n"
+			":rtype: bool",
+			(arg("address"))
+		)
+
+		.add_property("used",
+			&CFrameArena::GetUsed,
+			"Return the number of bytes that are used by the current frame."
+		)
+
+		.add_property("capacity",
+			&CFrameArena::GetCapacity,
+			"Return the number of bytes that are reserved by the arena."
+		)
+
+		.def_readwrite("poison",
+			&CFrameArena::m_bPoison,
+			"If True, released memory is overwritten to detect a use after the end of the frame."
+		)
+	;
+
+	_memory.attr("frame_arena") = object(ptr(GetFrameArena()));
+}
@@ -36,6 +36,7 @@
 // Utilities
 #include "memory_utilities.h"
 #include "memory_rtti.h"
+#include "memory_function.h"
 
 // Boost.Python
 #include "boost/python.hpp"
@@ -178,4 +179,21 @@ public:
 	}
 };
 
+// ============================================================================
+// >> CFunctionExt
+// ============================================================================
+class CFunctionExt
+{
+public:
+	// Used with raw_function() instead of raw_method(). The first argument is
+	// the instance and the rest is passed straight from the argument tuple.
+	template<object (CFunction::*Method)(PyObject**, int)>
+	static object Call(tuple args, dict kw)
+	{
+		CFunction* pFunc = extract<CFunction*>(PyTuple_GET_ITEM(args.ptr(), 0));
+		PyObject** ppArgs = PySequence_Fast_ITEMS(args.ptr());
+		return (pFunc->*Method)(ppArgs + 1, (int) PyTuple_GET_SIZE(args.ptr()) - 1);
+	}
+};
+
 #endif // _MEMORY_WRAP_H
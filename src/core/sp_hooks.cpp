@@ -42,6 +42,7 @@ using namespace boost::python;
 #include "utilities/call_python.h"
 #include "modules/entities/entities_entity.h"
 #include "modules/listeners/listeners_manager.h"
+#include "modules/memory/memory_hooks.h"
 
 
 //---------------------------------------------------------------------------------
@@ -93,10 +94,10 @@ bool ISimpleEntityHook::Initialize(CBaseEntity* pEntity)
 		return true;
 	}
 
-	CHook* pHook = GetHookManager()->FindHook((void*) func->m_ulAddr);
+	CHook* pHook = FindHook((void*) func->m_ulAddr);
 	if (!pHook)
 	{
-		pHook = GetHookManager()->HookFunction(
+		pHook = HookFunction(
 			(void*) func->m_ulAddr,
 			func->m_pCallingConvention);
 
@@ -54,7 +54,10 @@
 #include "datacache/imdlcache.h"
 #include "ivoiceserver.h"
 
-#include "manager.h"
+#include "modules/memory/memory_arena.h"
+#include "modules/memory/memory_deferred_hooks.h"
+#include "modules/memory/memory_hooks.h"
+#include "modules/memory/memory_vtable.h"
 
 #include "modules/listeners/listeners_manager.h"
 #include "utilities/conversions.h"
@@ -372,7 +375,7 @@ void CSourcePython::Unload( void )
 	Msg(MSG_PREFIX "Unloading...\n");
 	
 	DevMsg(1, MSG_PREFIX "Unhooking all functions...\n");
-	GetHookManager()->UnhookAllFunctions();
+	UnhookAllFunctions();
 
 #if defined(ENGINE_ORANGEBOX) || defined(ENGINE_BMS) || defined(ENGINE_GMOD)
 	if (m_pOldSpewOutputFunc)
@@ -466,6 +469,13 @@ void CSourcePython::ServerActivate( edict_t *pEdictList, int edictCount, int cli
 void CSourcePython::GameFrame( bool simulating )
 {
 	CALL_LISTENERS(OnTick);
+
+	// Must be done before the arena is reset, because the captured strings
+	// have been copied to it
+	GetDeferredHookBuffer()->Flush();
+
+	// Release all allocations of this frame
+	GetFrameArena()->Reset();
 }
 
 //-----------------------------------------------------------------------------
@@ -663,6 +673,9 @@ void CSourcePython::OnEntityDeleted( CBaseEntity *pEntity )
 {
 	CALL_LISTENERS(OnEntityDeleted, ptr((CBaseEntityWrapper*) pEntity));
 
+	// Remove per-instance hooks before the entity is gone
+	ReleaseInstanceVTable((unsigned long) pEntity);
+
 	unsigned int uiIndex;
 	if (!IndexFromBaseEntity(pEntity, uiIndex))
 		return;